@@ -0,0 +1,110 @@
+#ifndef COLLISION_H
+#define COLLISION_H
+
+#include <vector>
+#include <cmath>
+#include <cstdint>
+
+// Car-vs-car collision stage. Cars are circles of radius R; anything with
+// x, y, speed, hx, hy (unit heading, 0,-1 = up) and mass fields can be solved.
+//
+// Broad phase: cars are bucketed into a hashed grid of 2R cells with a
+// counting sort, so each car only tests the 3x3 cells around it. Below
+// gridFrom cars every pair is tested instead: bench.cpp has the two
+// crossing between 50 and 75 cars (about 12 us against 10 us at 50, 30 us
+// against 50 us at 100), and the grid 4.7x faster at 1000.
+// Narrow phase: overlapping pairs are pushed apart in proportion to mass and
+// get an impulse along the contact normal, repeated a fixed number of times.
+struct Collision
+{
+  std::vector<int> start, order, cellX, cellY, slot;   //kept between frames, only refilled
+  std::vector<float> vx, vy;
+  int mask;
+  float cell;
+  int gridFrom;   //fewer cars than this just test every pair
+
+  Collision() : mask(0), cell(0), gridFrom(64) {}
+
+  int hash(int cx,int cy) {return (uint32_t(cx)*73856093u ^ uint32_t(cy)*19349663u) & mask;}
+
+  template<class C> void build(C *car, int n)
+  {
+    int size=1; while(size<2*n) size*=2;
+    mask=size-1;
+    start.assign(size+1, 0);
+    order.resize(n); cellX.resize(n); cellY.resize(n);
+
+    for(int i=0;i<n;i++)
+    {
+      cellX[i]=std::floor(car[i].x/cell);
+      cellY[i]=std::floor(car[i].y/cell);
+      start[hash(cellX[i],cellY[i])+1]++;
+    }
+    for(int h=0;h<size;h++) start[h+1]+=start[h];
+    slot.assign(start.begin(), start.end()-1);
+    for(int i=0;i<n;i++) order[slot[hash(cellX[i],cellY[i])]++]=i;
+  }
+
+  template<class C> void resolve(C &a, C &b, int i, int j, float R, float e, bool impulse)
+  {
+    float dx=a.x-b.x, dy=a.y-b.y;
+    float d2=dx*dx+dy*dy;
+    if (d2>=4*R*R) return;
+
+    float d=std::sqrt(d2);
+    float nx=1, ny=0;              //exactly on top of each other: split along x
+    if (d>1e-4f) {nx=dx/d; ny=dy/d;}
+
+    float wa=1/a.mass, wb=1/b.mass, w=wa+wb;
+    float push=(2*R-d)/w;
+    a.x+=nx*push*wa; a.y+=ny*push*wa;
+    b.x-=nx*push*wb; b.y-=ny*push*wb;
+
+    if (!impulse) return;
+    float vn=(vx[i]-vx[j])*nx + (vy[i]-vy[j])*ny;
+    if (vn>=0) return;             //already separating
+    float J=-(1+e)*vn/w;
+    vx[i]+=J*wa*nx; vy[i]+=J*wa*ny;
+    vx[j]-=J*wb*nx; vy[j]-=J*wb*ny;
+  }
+
+  // e is restitution; only the first iteration exchanges momentum, the rest
+  // just remove the remaining overlap
+  template<class C> void solve(C *car, int n, float R, int iterations=4, float e=0.5)
+  {
+    cell=2*R;
+    vx.resize(n); vy.resize(n);
+    for(int i=0;i<n;i++)
+    {
+      vx[i]=car[i].hx*car[i].speed;
+      vy[i]=car[i].hy*car[i].speed;
+    }
+
+    for(int it=0;it<iterations && n<gridFrom;it++)
+      for(int i=0;i<n;i++)
+       for(int j=i+1;j<n;j++) resolve(car[i], car[j], i, j, R, e, it==0);
+
+    for(int it=0;it<iterations && n>=gridFrom;it++)
+    {
+      build(car, n);
+      for(int i=0;i<n;i++)
+       for(int cy=cellY[i]-1;cy<=cellY[i]+1;cy++)
+        for(int cx=cellX[i]-1;cx<=cellX[i]+1;cx++)
+         {
+           int h=hash(cx,cy);
+           for(int k=start[h];k<start[h+1];k++)
+           {
+             int j=order[k];
+             if (j<=i || cellX[j]!=cx || cellY[j]!=cy) continue; //each pair once, skip hash collisions
+             resolve(car[i], car[j], i, j, R, e, it==0);
+           }
+         }
+    }
+
+    // the car model only has speed along its heading, keep that component
+    for(int i=0;i<n;i++)
+      car[i].speed = vx[i]*car[i].hx + vy[i]*car[i].hy;
+  }
+};
+
+#endif
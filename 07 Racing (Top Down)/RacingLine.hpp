@@ -0,0 +1,250 @@
+#ifndef RACINGLINE_H
+#define RACINGLINE_H
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <cmath>
+#include <algorithm>
+
+// Checkpoints of the track in world pixels (background drawn at 2x), in
+// driving order. They seed the racing line when no table has been built.
+const int num=8;
+const int points[num][2] = {300, 610,
+                            1270,430,
+                            1380,2380,
+                            1900,2460,
+                            1970,1700,
+                            2550,1680,
+                            2560,3150,
+                            500, 3300};
+
+// which pixels of the track image a car can drive on (the dirt, not walls
+// or tyres): a guess from the colour, there is no hand-made mask
+inline bool drivable(int r,int g,int b) {return r>g+40 && b<60;}
+
+// Signed distance in world pixels from every mask pixel to the nearest
+// wall (negative inside walls: distance to the nearest drivable pixel),
+// from two 3-4 chamfer passes. Used to keep the line off the walls.
+struct TrackMask
+{
+  int w,h; float scale;
+  std::vector<float> dist;
+
+  TrackMask(int W,int H,float S,std::vector<unsigned char> road) : w(W), h(H), scale(S), dist(W*H)
+  {
+    // thin dark lines painted on the dirt aren't walls: drop anything
+    // undrivable that is less than 5 pixels across in x or y
+    std::vector<unsigned char> open = road;
+    for(int y=0;y<h;y++)
+     for(int x=0;x<w;x++)
+      if (!road[y*w+x])
+       {
+        int l=0, r=0, u=0, d=0;
+        while (l<2 && x-l-1>=0 && !road[y*w+x-l-1]) l++;
+        while (r<2 && x+r+1<w && !road[y*w+x+r+1]) r++;
+        while (u<2 && y-u-1>=0 && !road[(y-u-1)*w+x]) u++;
+        while (d<2 && y+d+1<h && !road[(y+d+1)*w+x]) d++;
+        if (l+r<4 || u+d<4) open[y*w+x]=1;
+       }
+    road = open;
+
+    std::vector<float> in = chamfer(road, 1), out = chamfer(road, 0);
+    for(int i=0;i<w*h;i++) dist[i] = (road[i] ? in[i] : -out[i])*scale/3;
+  }
+
+  // distance to the nearest pixel that isn't `side`
+  std::vector<float> chamfer(const std::vector<unsigned char> &road, bool side)
+  {
+    std::vector<float> d(w*h);
+    for(int i=0;i<w*h;i++) d[i] = bool(road[i])==side ? 1e6f : 0;
+    auto relax = [&](int i,int x,int y,float c)
+     {if (x>=0 && y>=0 && x<w && y<h) d[i]=std::min(d[i], d[y*w+x]+c);};
+    for(int y=0;y<h;y++)
+     for(int x=0;x<w;x++)
+      {int i=y*w+x; relax(i,x-1,y,3); relax(i,x,y-1,3); relax(i,x-1,y-1,4); relax(i,x+1,y-1,4);}
+    for(int y=h-1;y>=0;y--)
+     for(int x=w-1;x>=0;x--)
+      {int i=y*w+x; relax(i,x+1,y,3); relax(i,x,y+1,3); relax(i,x+1,y+1,4); relax(i,x-1,y+1,4);}
+    return d;
+  }
+
+  float at(float x,float y) const
+  {
+    int px=x/scale, py=y/scale;
+    if (px<0 || py<0 || px>=w || py>=h) return -1e6f;
+    return dist[py*w+px];
+  }
+};
+
+struct LinePoint {float x,y,curve,speed;};
+
+// Dense closed racing line: evenly spaced points with signed curvature
+// (positive = turning clockwise, i.e. car angle increasing) and the target
+// speed in pixels per frame.
+struct RacingLine
+{
+  std::vector<LinePoint> p;
+  float step;
+
+  int size() const {return p.size();}
+  const LinePoint& operator[](int i) const {return p[(i%size()+size())%size()];}
+
+  // closed Catmull-Rom spline through the checkpoints, resampled every `spacing` pixels
+  void fromPoints(const int pts[][2], int n, float spacing)
+  {
+    std::vector<LinePoint> dense;
+    for(int i=0;i<n;i++)
+     for(int k=0;k<64;k++)
+     {
+       const int *a=pts[(i+n-1)%n], *b=pts[i], *c=pts[(i+1)%n], *d=pts[(i+2)%n];
+       float t=k/64.f, t2=t*t, t3=t2*t;
+       LinePoint q = LinePoint();
+       q.x = 0.5f*(2*b[0] + (c[0]-a[0])*t + (2*a[0]-5*b[0]+4*c[0]-d[0])*t2 + (3*b[0]-a[0]-3*c[0]+d[0])*t3);
+       q.y = 0.5f*(2*b[1] + (c[1]-a[1])*t + (2*a[1]-5*b[1]+4*c[1]-d[1])*t2 + (3*b[1]-a[1]-3*c[1]+d[1])*t3);
+       dense.push_back(q);
+     }
+    p = dense;
+    resample(spacing);
+  }
+
+  void resample(float spacing)
+  {
+    std::vector<LinePoint> out;
+    float len=0;
+    for(int i=0;i<size();i++) len += std::hypot(p[(i+1)%size()].x-p[i].x, p[(i+1)%size()].y-p[i].y);
+    int n = std::max(3, int(len/spacing));
+    step = len/n;
+
+    float want=0, at=0;
+    for(int i=0; int(out.size())<n; i=(i+1)%size())
+    {
+      const LinePoint &a=p[i], &b=p[(i+1)%size()];
+      float l = std::hypot(b.x-a.x, b.y-a.y);
+      while (want <= at+l && int(out.size())<n)
+      {
+        float t = l>0 ? (want-at)/l : 0;
+        LinePoint q = LinePoint();
+        q.x = a.x+(b.x-a.x)*t; q.y = a.y+(b.y-a.y)*t;
+        out.push_back(q);
+        want += step;
+      }
+      at += l;
+    }
+    p = out;
+  }
+
+  // elastic band: pull every point towards its neighbours (shortens the line
+  // and cuts corners) while keeping `margin` pixels from walls
+  void relax(const TrackMask &mask, float margin, int iterations)
+  {
+    for(int it=0;it<iterations;it++)
+    {
+      for(int i=0;i<size();i++)
+      {
+        LinePoint &q = p[i];
+        const LinePoint &a=(*this)[i-1], &b=(*this)[i+1];
+        float d = mask.at(q.x,q.y);
+        float nx = q.x + 0.5f*((a.x+b.x)/2-q.x), ny = q.y + 0.5f*((a.y+b.y)/2-q.y);
+
+        if (d<margin) //too close to a wall: climb the distance field
+        {
+          float gx = mask.at(q.x+4,q.y)-mask.at(q.x-4,q.y);
+          float gy = mask.at(q.x,q.y+4)-mask.at(q.x,q.y-4);
+          float g = std::hypot(gx,gy);
+          if (g>0) {nx = q.x+gx/g*4; ny = q.y+gy/g*4;}
+        }
+        float nd = mask.at(nx,ny);
+        if (nd>=margin || nd>d) {q.x=nx; q.y=ny;}
+      }
+      if (it%50==49) resample(step);
+    }
+  }
+
+  // resampling puts points on the chords between the old ones, and a chord
+  // can cut through a wall at a corner: climb the distance field with any
+  // point closer than `margin` until it is clear, or at least on the road
+  void clamp(const TrackMask &mask, float margin)
+  {
+    for(auto &q: p)
+     for(int k=0;k<64;k++)
+      {
+        float d = mask.at(q.x,q.y);
+        if (d>=margin) break;
+        float gx = mask.at(q.x+4,q.y)-mask.at(q.x-4,q.y);
+        float gy = mask.at(q.x,q.y+4)-mask.at(q.x,q.y-4);
+        float g = std::hypot(gx,gy);
+        if (g<=0 || (d>=0 && mask.at(q.x+gx/g*2,q.y+gy/g*2)<=d)) break;   //a ridge: as clear as it gets here
+        q.x+=gx/g*2; q.y+=gy/g*2;
+      }
+  }
+
+  // curvature from every point's neighbours `k` steps away, then the speed
+  // each point allows (lateral grip), limited by braking before and
+  // acceleration after corners; the line is closed so passes go round twice
+  void profile(float maxSpeed, float grip, float acc, float dec, int k=4)
+  {
+    int n=size();
+    for(int i=0;i<n;i++)
+    {
+      const LinePoint &a=(*this)[i-k], &b=p[i], &c=(*this)[i+k];
+      float cross = (b.x-a.x)*(c.y-b.y) - (b.y-a.y)*(c.x-b.x);
+      float la=std::hypot(b.x-a.x,b.y-a.y), lb=std::hypot(c.x-b.x,c.y-b.y), lc=std::hypot(c.x-a.x,c.y-a.y);
+      p[i].curve = la*lb*lc>0 ? 2*cross/(la*lb*lc) : 0;
+      p[i].speed = std::min(maxSpeed, std::sqrt(grip/std::max(std::abs(p[i].curve),1e-6f)));
+    }
+
+    // v^2 = u^2 + 2*a*s
+    for(int r=0;r<2;r++)
+     for(int i=2*n-1;i>=0;i--)
+      {LinePoint &q=p[i%n]; q.speed=std::min(q.speed, std::sqrt((*this)[i+1].speed*(*this)[i+1].speed + 2*dec*step));}
+    for(int r=0;r<2;r++)
+     for(int i=0;i<2*n;i++)
+      {LinePoint &q=p[i%n]; q.speed=std::min(q.speed, std::sqrt((*this)[i-1].speed*(*this)[i-1].speed + 2*acc*step));}
+  }
+
+  // index of the line point nearest to (x,y), searching a few points around
+  // the previous answer: constant work per car per frame
+  int nearest(int hint, float x, float y) const
+  {
+    int best=hint; float bd=1e30f;
+    for(int i=hint-2;i<=hint+8;i++)
+    {
+      const LinePoint &q=(*this)[i];
+      float d=(q.x-x)*(q.x-x)+(q.y-y)*(q.y-y);
+      if (d<bd) {bd=d; best=(i+size())%size();}
+    }
+    return best;
+  }
+
+  int nearestAll(float x, float y) const
+  {
+    int best=0; float bd=1e30f;
+    for(int i=0;i<size();i++)
+    {
+      float d=(p[i].x-x)*(p[i].x-x)+(p[i].y-y)*(p[i].y-y);
+      if (d<bd) {bd=d; best=i;}
+    }
+    return best;
+  }
+
+  bool save(const std::string &file) const
+  {
+    std::ofstream out(file);
+    out<<size()<<" "<<step<<"\n";
+    for(auto &q: p) out<<q.x<<" "<<q.y<<" "<<q.curve<<" "<<q.speed<<"\n";
+    return bool(out);
+  }
+
+  bool load(const std::string &file)
+  {
+    std::ifstream in(file);
+    int n;
+    if (!(in>>n>>step) || n<3) return false;
+    p.resize(n);
+    for(auto &q: p) in>>q.x>>q.y>>q.curve>>q.speed;
+    return bool(in);
+  }
+};
+
+#endif
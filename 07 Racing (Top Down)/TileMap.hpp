@@ -0,0 +1,90 @@
+#ifndef TILEMAP_H
+#define TILEMAP_H
+
+#include <SFML/Graphics.hpp>
+#include <algorithm>
+#include <fstream>
+#include <list>
+#include <unordered_map>
+#include <vector>
+#include <string>
+
+// The track background cut into square tiles (see tiles.cpp), streamed in
+// as the camera moves. Only `capacity` tiles live on the GPU at once, the
+// least recently drawn one is reused when a new tile comes into view.
+// Nothing holds the whole image, so a track can be any size.
+struct TileMap
+{
+  int size, cols, rows, width, height;   //size in texels, width and height in world pixels
+  float scale;                   //tile texels to world pixels
+  std::string dir;
+
+  std::vector<sf::Texture> slots;
+  std::vector<int> slotTile;
+  std::unordered_map<int,int> tileSlot;
+  std::list<int> lru;            //slots, most recently used first
+  std::vector<std::list<int>::iterator> lruPos;
+
+  TileMap(int capacity=32) : slots(capacity), slotTile(capacity,-1), lruPos(capacity)
+  {
+    size=cols=rows=width=height=0; scale=1;
+    for(int i=0;i<capacity;i++) lruPos[i]=lru.insert(lru.end(), i);
+  }
+
+  // dir/index.txt holds "tileSize cols rows imageWidth imageHeight scale"
+  bool load(const std::string &tileDir)
+  {
+    dir=tileDir;
+    std::ifstream index(dir+"/index.txt");
+    int w,h;
+    if (!(index >> size >> cols >> rows >> w >> h >> scale)) return false;
+    width = w*scale;
+    height = h*scale;
+    return true;
+  }
+
+  int tileW() {return size*scale;}
+
+  sf::Texture& tile(int tx,int ty)
+  {
+    int id = ty*cols+tx;
+    auto it = tileSlot.find(id);
+    int s;
+    if (it!=tileSlot.end()) s = it->second;
+    else
+    {
+      s = lru.back();
+      if (slotTile[s]>=0) tileSlot.erase(slotTile[s]);
+      slotTile[s]=id; tileSlot[id]=s;
+
+      slots[s].loadFromFile(dir+"/"+std::to_string(tx)+"_"+std::to_string(ty)+".png");
+      slots[s].setSmooth(true);
+    }
+    lru.splice(lru.begin(), lru, lruPos[s]);
+    return slots[s];
+  }
+
+  // draws the tiles overlapping the view whose top left is (x,y) in world
+  // pixels, each without its border: smoothing reads the border at the
+  // edges, which holds the neighbour's texels, so tiles meet without seams
+  void draw(sf::RenderTarget &target, int x, int y, int viewW, int viewH)
+  {
+    int t = tileW();
+    int x0 = std::max(0, x/t), x1 = std::min(cols-1, (x+viewW-1)/t);
+    int y0 = std::max(0, y/t), y1 = std::min(rows-1, (y+viewH-1)/t);
+
+    sf::Sprite s;
+    s.setScale(scale, scale);
+    for(int ty=y0;ty<=y1;ty++)
+     for(int tx=x0;tx<=x1;tx++)
+      {
+        sf::Texture &tex = tile(tx,ty);
+        s.setTexture(tex);
+        s.setTextureRect(sf::IntRect(1, 1, tex.getSize().x-2, tex.getSize().y-2));
+        s.setPosition(tx*t - x, ty*t - y);
+        target.draw(s);
+      }
+  }
+};
+
+#endif
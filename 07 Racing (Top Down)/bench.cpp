@@ -0,0 +1,54 @@
+// Collision stage timing against car count:
+//   g++ -std=c++11 -O2 bench.cpp -o bench && ./bench
+// Cars are spread over an area that grows with their number, so density
+// (and contacts per car) stays about what a crowded race start looks like.
+// Solving pushes them apart, so every frame starts again from the same
+// spread; the time to copy it back is measured alone and taken off.
+// Both ways Collision can find the pairs are timed, the grid and testing
+// every pair, to place gridFrom where they cross.
+#include <chrono>
+#include <cstdio>
+#include <vector>
+#include <random>
+#include "Collision.hpp"
+
+struct Car {float x,y,speed,hx,hy,mass;};
+
+const float R=22;
+
+std::vector<Car> field(int n, std::mt19937 &rnd)
+{
+  float side = std::sqrt(n*60.f*60.f);
+  std::uniform_real_distribution<float> pos(0,side), ang(0,6.283f), spd(0,12);
+  std::vector<Car> car(n);
+  for(auto &c: car) {float a=ang(rnd); c = Car{pos(rnd), pos(rnd), spd(rnd), std::sin(a), -std::cos(a), 1};}
+  return car;
+}
+
+template<class F> double usPerFrame(F f, int frames)
+{
+  auto t0 = std::chrono::steady_clock::now();
+  for(int i=0;i<frames;i++) f();
+  return std::chrono::duration<double,std::micro>(std::chrono::steady_clock::now()-t0).count()/frames;
+}
+
+int main()
+{
+  std::mt19937 rnd(1);
+  Collision col;
+  std::printf("%8s %14s %14s\n", "cars", "grid us/frame", "pairs us/frame");
+
+  for(int n: {5, 10, 25, 50, 75, 100, 150, 250, 500, 1000, 2000, 5000})
+  {
+    const std::vector<Car> start = field(n, rnd);
+    std::vector<Car> a = start;
+    int frames = 2000000/(n*10) + 10;
+    double copy = usPerFrame([&]{ a = start; }, frames);
+    col.gridFrom = 0;
+    double g = usPerFrame([&]{ a = start; col.solve(a.data(), n, R); }, frames) - copy;
+    col.gridFrom = n+1;
+    double s = n<=2000 ? usPerFrame([&]{ a = start; col.solve(a.data(), n, R); }, frames/10+1) - copy : 0;
+    std::printf("%8d %14.2f %14.2f\n", n, g, s);
+  }
+  return 0;
+}
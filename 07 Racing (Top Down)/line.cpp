@@ -0,0 +1,42 @@
+// Builds the AI racing line table from the track image:
+//   g++ -std=c++11 -O2 line.cpp -o line -lsfml-graphics -lsfml-system
+//   ./line images/background.png images/racing_line.txt
+// The checkpoints are joined by a spline, pulled tight around the corners
+// while staying clear of the walls, and given a curvature and speed profile.
+// There is no separate mask image: what counts as road is guessed from the
+// colours of the background (drivable() in RacingLine.hpp), and thin lines
+// painted on the dirt are let through.
+#include <SFML/Graphics.hpp>
+#include <iostream>
+#include "RacingLine.hpp"
+using namespace sf;
+
+int main(int argc, char *argv[])
+{
+  if (argc<3) {std::cout<<"usage: line <track image> <out table> [scale]\n"; return 1;}
+  float scale = argc>3 ? std::stof(argv[3]) : 2;
+
+  Image img;
+  if (!img.loadFromFile(argv[1])) return 1;
+  int w=img.getSize().x, h=img.getSize().y;
+
+  std::vector<unsigned char> road(w*h);
+  for(int y=0;y<h;y++)
+   for(int x=0;x<w;x++)
+    {
+      Color c = img.getPixel(x,y);
+      road[y*w+x] = drivable(c.r,c.g,c.b);
+    }
+
+  TrackMask mask(w,h,scale,road);
+  RacingLine line;
+  line.fromPoints(points, num, 16);
+  line.relax(mask, 30, 600);
+  line.clamp(mask, 30);
+  line.profile(12, 0.3, 0.2, 0.3);
+
+  float lap=0;
+  for(auto &q: line.p) lap += line.step/q.speed;
+  std::cout<<line.size()<<" points, ideal lap "<<int(lap)<<" frames\n";
+  return line.save(argv[2]) ? 0 : 1;
+}
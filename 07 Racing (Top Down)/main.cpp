@@ -1,35 +1,46 @@
 #include <SFML/Graphics.hpp>
+#include <cstdio>
+#include "TileMap.hpp"
+#include "Collision.hpp"
+#include "RacingLine.hpp"
 using namespace sf;
 
-const int num=8; //checkpoints
-int points[num][2] = {300, 610,
-                      1270,430,
-                      1380,2380,
-                      1900,2460,
-                      1970,1700,
-                      2550,1680,
-                      2560,3150,
-                      500, 3300};
-
 struct Car
 {
-  float x,y,speed,angle; int n;
+  float x,y,speed,maxSpeed,angle,mass,hx,hy; int n;
 
-  Car() {speed=2; angle=0; n=0;}
+  Car() {speed=maxSpeed=2; angle=0; mass=1; hx=0; hy=-1; n=0;}
+
+  // angle is only kept for drawing; the heading (hx,hy) is rotated by the
+  // small turn with a few series terms and pulled back to unit length,
+  // so no car needs sin/cos in a frame
+  void turn(float a)
+   {
+    angle += a;
+    float a2 = a*a, c = 1 - a2/2 + a2*a2/24, s = a*(1 - a2/6);
+    float x1 = hx*c - hy*s, y1 = hy*c + hx*s;
+    float k = 1.5f - 0.5f*(x1*x1 + y1*y1);
+    hx = x1*k; hy = y1*k;
+   }
 
   void move()
    {
-    x += sin(angle) * speed;
-    y -= cos(angle) * speed;
+    x += hx * speed;
+    y += hy * speed;
    }
 
-  void findTarget()
+  // steer by the line's curvature plus a correction towards a point a few
+  // steps ahead, drive at the line's speed scaled by this car's top speed
+  void findTarget(const RacingLine &line)
   {
-    float tx=points[n][0];
-    float ty=points[n][1];
-    float beta = angle-atan2(tx-x,-ty+y);
-    if (sin(beta)<0) angle+=0.005*speed; else angle-=0.005*speed;
-    if ((x-tx)*(x-tx)+(y-ty)*(y-ty)<25*25) n=(n+1)%num;
+    n = line.nearest(n, x, y);
+    const LinePoint &t = line[n+6];
+    float cross = hx*(t.y-y) - hy*(t.x-x);
+    turn(line[n].curve*speed + 0.05*cross/(6*line.step));
+
+    float target = line[n].speed*maxSpeed/12;
+    if (speed<target) speed=std::min(target, speed+0.2f);
+    else speed=std::max(target, speed-0.3f);
    }
 };
 
@@ -39,33 +50,40 @@ int main()
     RenderWindow app(VideoMode(640, 480), "Car Racing Game!");
 	app.setFramerateLimit(60);
 
-    Texture t1,t2,t3;
-    t1.loadFromFile("images/background.png");
+    Texture t2;
     t2.loadFromFile("images/car.png");
-    t1.setSmooth(true);
     t2.setSmooth(true);
 
-    Sprite sBackground(t1), sCar(t2);
-    sBackground.scale(2,2);
+    TileMap track;
+    if (!track.load("images/tiles")) {printf("images/tiles is missing, see tiles.cpp\n"); return 1;}
+
+    Sprite sCar(t2);
 
     sCar.setOrigin(22, 22);
     float R=22;
 
+    RacingLine line;
+    if (!line.load("images/racing_line.txt"))
+     {line.fromPoints(points, num, 16); line.profile(12, 0.3, 0.2, 0.3);}
+
     const int N=5;
     Car car[N];
     for(int i=0;i<N;i++)
     {
       car[i].x=300+i*50;
       car[i].y=1700+i*80;
-      car[i].speed=7+i;
+      car[i].speed=car[i].maxSpeed=7+i;
+      car[i].n=line.nearestAll(car[i].x, car[i].y);
     }
 
-   float speed=0,angle=0;
+   float speed=0;
    float maxSpeed=12.0;
+   car[0].maxSpeed=maxSpeed;
    float acc=0.2, dec=0.3;
    float turnSpeed=0.08;
 
    int offsetX=0,offsetY=0;
+   Collision collision;
 
     while (app.isOpen())
     {
@@ -96,40 +114,28 @@ int main()
         else if (speed + dec < 0) speed += dec;
         else speed = 0;
 
-    if (Right && speed!=0)  angle += turnSpeed * speed/maxSpeed;
-    if (Left && speed!=0)   angle -= turnSpeed * speed/maxSpeed;
+    if (Right && speed!=0)  car[0].turn(turnSpeed * speed/maxSpeed);
+    if (Left && speed!=0)   car[0].turn(-turnSpeed * speed/maxSpeed);
 
     car[0].speed = speed;
-    car[0].angle = angle;
 
 	for(int i=0;i<N;i++) car[i].move();
-	for(int i=1;i<N;i++) car[i].findTarget();
+	for(int i=1;i<N;i++) car[i].findTarget(line);
 
     //collision
-    for(int i=0;i<N;i++)
-    for(int j=0;j<N;j++)
-    {      
-		int dx=0, dy=0;
-        while (dx*dx+dy*dy<4*R*R)
-         {
-           car[i].x+=dx/10.0;
-           car[i].x+=dy/10.0;
-           car[j].x-=dx/10.0;
-           car[j].y-=dy/10.0;
-		   dx = car[i].x-car[j].x;
-           dy = car[i].y-car[j].y;
-		   if (!dx && !dy) break;
-         }
-    }
-
+    collision.solve(car, N, R);
+    for(int i=0;i<N;i++)   //a push can't take a car past its top speed, either way
+      car[i].speed = std::max(-car[i].maxSpeed, std::min(car[i].maxSpeed, car[i].speed));
+    speed = car[0].speed;
 
     app.clear(Color::White);
 
     if (car[0].x>320) offsetX = car[0].x-320;
     if (car[0].y>240) offsetY = car[0].y-240;
+    if (offsetX>track.width-640) offsetX = track.width-640;
+    if (offsetY>track.height-480) offsetY = track.height-480;
 
-    sBackground.setPosition(-offsetX,-offsetY);
-    app.draw(sBackground);
+    track.draw(app, offsetX, offsetY, 640, 480);
 
     Color colors[10] = {Color::Red, Color::Green, Color::Magenta, Color::Blue, Color::White};
 
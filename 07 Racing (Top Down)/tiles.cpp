@@ -0,0 +1,62 @@
+// Cuts the track image into tiles for TileMap.hpp. images/tiles in the
+// repository was made with the defaults; run it again after changing the
+// track:
+//   g++ -std=c++11 tiles.cpp -o tiles -lsfml-graphics -lsfml-system
+//   ./tiles images/background.png images/tiles [tile size=256] [scale=2]
+// Writes dir/X_Y.png plus dir/index.txt. Every tile carries a 1-texel
+// border copied from its neighbours (the image edge repeats), so the game
+// can draw the tiles `scale` times larger with smoothing and no seams.
+#include <SFML/Graphics.hpp>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <algorithm>
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+using namespace sf;
+
+int main(int argc, char *argv[])
+{
+  if (argc<3) {std::cout<<"usage: tiles <image> <out dir> [tile size=256] [scale=2]\n"; return 1;}
+
+  Image src;
+  if (!src.loadFromFile(argv[1])) return 1;
+  std::string dir = argv[2];
+  int size = argc>3 ? std::stoi(argv[3]) : 256;
+  float scale = argc>4 ? std::stof(argv[4]) : 2;
+
+#ifdef _WIN32
+  _mkdir(dir.c_str());
+#else
+  mkdir(dir.c_str(), 0755);
+#endif
+
+  int width = src.getSize().x, height = src.getSize().y;
+  int cols = (width+size-1)/size, rows = (height+size-1)/size;
+
+  for(int ty=0;ty<rows;ty++)
+   for(int tx=0;tx<cols;tx++)
+    {
+      int w = std::min(size, width-tx*size), h = std::min(size, height-ty*size);
+      Image tile;
+      tile.create(w+2,h+2);
+      for(int y=0;y<h+2;y++)
+       for(int x=0;x<w+2;x++)
+        {
+          int sx = std::min(std::max(tx*size+x-1,0), width-1);
+          int sy = std::min(std::max(ty*size+y-1,0), height-1);
+          tile.setPixel(x,y, src.getPixel(sx,sy));
+        }
+
+      std::string name = dir+"/"+std::to_string(tx)+"_"+std::to_string(ty)+".png";
+      if (!tile.saveToFile(name)) {std::cout<<"can't write "<<name<<"\n"; return 1;}
+    }
+
+  std::ofstream index(dir+"/index.txt");
+  index<<size<<" "<<cols<<" "<<rows<<" "<<width<<" "<<height<<" "<<scale<<"\n";
+  std::cout<<cols*rows<<" tiles of "<<size<<", "<<width<<"x"<<height<<" drawn at "<<scale<<"x\n";
+  return 0;
+}
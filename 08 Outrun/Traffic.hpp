@@ -0,0 +1,154 @@
+#ifndef TRAFFIC_H
+#define TRAFFIC_H
+
+#include <vector>
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+#include "../common/Jobs.hpp"
+
+// AI cars driving along the track. Position z is in world units along the
+// road, x is across the road in half-road widths (-1..1, like playerX).
+struct Car
+{
+  float z,x,speed,maxSpeed;
+  int lane,color;
+};
+
+const int lanes = 3;
+const float laneX[lanes] = {-0.66, 0, 0.66};
+const float carW = 0.45;   //car width in half-road widths
+const int lookAhead = 10;  //segments scanned ahead for traffic
+
+struct Traffic
+{
+  std::vector<Car> cars, next; //current state and the one being written this frame
+  std::vector<int> segStart, segCars; //segment index: cars on s are segCars[segStart[s]..segStart[s+1])
+  int N, segL;
+
+  Traffic(int segments, int segLength) : N(segments), segL(segLength) {}
+
+  void spawn(int count, uint32_t seed)
+  {
+    cars.resize(count);
+    for(int i=0;i<count;i++)
+    {
+      Car &c = cars[i];
+      seed = seed*1664525 + 1013904223;
+      c.lane = (seed>>8)%lanes;
+      c.x = laneX[c.lane];
+      c.z = float(i)*N*segL/count;
+      c.maxSpeed = 80 + (seed>>16)%100;
+      c.speed = c.maxSpeed;
+      c.color = (seed>>4)%6;
+    }
+    next = cars;
+    index();
+  }
+
+  int seg(float z) {return int(z/segL)%N;}
+
+  // counting sort of cars by segment, cars inside one segment far to near
+  void index()
+  {
+    segStart.assign(N+1, 0);
+    segCars.resize(cars.size());
+    for(auto &c: cars) segStart[seg(c.z)+1]++;
+    for(int s=0;s<N;s++) segStart[s+1]+=segStart[s];
+
+    std::vector<int> fill(segStart.begin(), segStart.end()-1);
+    for(int i=0;i<int(cars.size());i++) segCars[fill[seg(cars[i].z)]++]=i;
+
+    for(int s=0;s<N;s++)
+     for(int a=segStart[s]+1;a<segStart[s+1];a++)
+       for(int b=a; b>segStart[s] && cars[segCars[b]].z > cars[segCars[b-1]].z; b--)
+         std::swap(segCars[b], segCars[b-1]);
+  }
+
+  float ahead(const Car &a, const Car &b) //distance from a forward to b
+  {
+    float d = b.z - a.z;
+    if (d<0) d += N*segL;
+    return d;
+  }
+
+  // nearest car to c across x between segments from..to relative to c, -1 if none
+  int blocker(int self, float x, int from, int to, float &dist)
+  {
+    const Car &c = cars[self];
+    int best=-1; dist=1e9;
+    for(int n=from;n<=to;n++)
+    {
+      int s = ((seg(c.z)+n)%N+N)%N;
+      for(int k=segStart[s];k<segStart[s+1];k++)
+      {
+        int j = segCars[k];
+        if (j==self || std::abs(cars[j].x-x)>carW) continue;
+        float d = ahead(c, cars[j]);
+        if (d > N*segL/2) d -= N*segL;
+        if (d < from*segL || d > to*segL) continue;
+        if (std::abs(d) < std::abs(dist)) {dist=d; best=j;}
+      }
+    }
+    return best;
+  }
+
+  void updateCar(int i)
+  {
+    Car c = cars[i];
+    float dist;
+    int b = blocker(i, c.x, 0, lookAhead, dist);
+
+    if (b>=0 && dist < 6*segL && cars[b].speed < c.speed)
+    {
+      // overtake if a neighbouring lane is clear, else follow the slower car
+      int lane=-1; float gap;
+      for(int d=-1;d<=1 && lane<0;d+=2)
+      {
+        int l = c.lane + (i%2 ? d : -d);
+        if (l<0 || l>=lanes) continue;
+        if (blocker(i, laneX[l], -2, lookAhead/2, gap)<0) lane=l;
+      }
+      if (lane>=0) c.lane=lane;
+      else c.speed = std::max(cars[b].speed, c.speed-4);
+    }
+    else if (c.speed < c.maxSpeed) c.speed = std::min(c.maxSpeed, c.speed+2);
+
+    float tx = laneX[c.lane];
+    if (c.x < tx) c.x = std::min(tx, c.x+0.02f);
+    if (c.x > tx) c.x = std::max(tx, c.x-0.02f);
+
+    c.z += c.speed;
+    if (c.z >= N*segL) c.z -= N*segL;
+    next[i]=c;
+  }
+
+  // every car reads last frame's state and writes only its own entry,
+  // so jobs need no locking and the result doesn't depend on thread count
+  void update(Jobs &jobs)
+  {
+    jobs.run(cars.size(), 64, [this](int a,int b){ for(int i=a;i<b;i++) updateCar(i); });
+    cars.swap(next);
+    index();
+  }
+
+  // car the player runs into, looks only at segments near the camera
+  int hitPlayer(int pos, float playerX)
+  {
+    int s = pos/segL;
+    for(int n=0;n<=2;n++)
+    {
+      int q = (s+n)%N;
+      for(int k=segStart[q];k<segStart[q+1];k++)
+      {
+        const Car &c = cars[segCars[k]];
+        float d = c.z - pos;
+        if (d<0) d += N*segL;
+        if (d < 2*segL && std::abs(c.x-playerX) < carW) return segCars[k];
+      }
+    }
+    return -1;
+  }
+};
+
+#endif
@@ -1,4 +1,6 @@
 #include <SFML/Graphics.hpp>
+#include <time.h>
+#include "Traffic.hpp"
 using namespace sf;
 
 int width = 1024;
@@ -59,6 +61,30 @@ struct Line
     s.setPosition(destX, destY);
     app.draw(s);
     }
+
+  void drawCar(RenderWindow &app, const Car &c)
+  {
+    const Color paint[6] = {Color::Red, Color::Blue, Color::Yellow, Color::White, Color(255,128,0), Color(128,0,160)};
+
+    float destW = W * carW;
+    float destH = destW * 0.55;
+    float destX = X + W * c.x - destW/2;
+    float destY = Y - destH;
+
+    float clipH = destY+destH-clip;
+    if (clipH<0) clipH=0;
+    if (clipH>=destH) return;
+
+    RectangleShape body(Vector2f(destW, destH-clipH));
+    body.setFillColor(paint[c.color]);
+    body.setPosition(destX, destY);
+    app.draw(body);
+
+    RectangleShape glass(Vector2f(destW*0.7, std::min(destH*0.35f, destH-clipH)));
+    glass.setFillColor(Color(40,40,60));
+    glass.setPosition(destX + destW*0.15, destY);
+    app.draw(glass);
+  }
 };
 
 
@@ -109,6 +135,10 @@ int main()
    int pos = 0;
    int H = 1500;
 
+   Jobs jobs;
+   Traffic traffic(N, segL);
+   traffic.spawn(400, time(0));
+
     while (app.isOpen())
     {
         Event e;
@@ -128,6 +158,10 @@ int main()
   if (Keyboard::isKeyPressed(Keyboard::W)) H+=100;
   if (Keyboard::isKeyPressed(Keyboard::S)) H-=100;
 
+  traffic.update(jobs);
+  int hit = traffic.hitPlayer(pos, playerX);
+  if (hit>=0 && speed>traffic.cars[hit].speed) speed = traffic.cars[hit].speed;
+
   pos+=speed;
   while (pos >= N*segL) pos-=N*segL;
   while (pos < 0) pos += N*segL;
@@ -167,7 +201,12 @@ int main()
 
     ////////draw objects////////
     for(int n=startPos+300; n>startPos; n--)
-      lines[n%N].drawSprite(app);
+     {
+      Line &l = lines[n%N];
+      l.drawSprite(app);
+      for(int k=traffic.segStart[n%N]; k<traffic.segStart[n%N+1]; k++)
+        l.drawCar(app, traffic.cars[traffic.segCars[k]]);
+     }
 
     app.display();
     }
@@ -0,0 +1,101 @@
+#ifndef ENEMIES_H
+#define ENEMIES_H
+
+#include <vector>
+#include <cstdlib>
+#include <atomic>
+#include <cstdint>
+#include "../common/Jobs.hpp"
+
+// For every cell, how many cells it is to the nearest wall (grid value 1) to
+// the left, right, up and down; 0 on walls. Rows and columns are rebuilt
+// only when a capture changed them.
+struct Walls
+{
+  int rows, cols; const int *grid;
+  std::vector<uint16_t> left, right, up, down;
+
+  Walls(const int *g, int M, int N) : rows(M), cols(N), grid(g), left(M*N), right(M*N), up(M*N), down(M*N)
+  {
+    for(int i=0;i<rows;i++) row(i);
+    for(int j=0;j<cols;j++) col(j);
+  }
+
+  void row(int i)
+  {
+    const int *g = grid+i*cols;
+    uint16_t *l = &left[i*cols], *r = &right[i*cols];
+    for(int j=0;j<cols;j++) l[j] = g[j]==1 ? 0 : (j ? l[j-1] : 0)+1;
+    for(int j=cols-1;j>=0;j--) r[j] = g[j]==1 ? 0 : (j<cols-1 ? r[j+1] : 0)+1;
+  }
+
+  void col(int j)
+  {
+    for(int i=0;i<rows;i++) up[i*cols+j] = grid[i*cols+j]==1 ? 0 : (i ? up[(i-1)*cols+j] : 0)+1;
+    for(int i=rows-1;i>=0;i--) down[i*cols+j] = grid[i*cols+j]==1 ? 0 : (i<rows-1 ? down[(i+1)*cols+j] : 0)+1;
+  }
+};
+
+// Bouncing enemies as parallel arrays, positions in pixels.
+struct Enemies
+{
+  std::vector<int> x,y,dx,dy;
+  int ts;
+
+  Enemies(int tileSize) : ts(tileSize) {}
+
+  int size() {return x.size();}
+
+  // each one somewhere in a random free cell, moving diagonally: a shared
+  // start point made them travel in clumps, and a zero step left some still
+  void spawn(int n, const int *grid, int rows, int cols)
+  {
+    std::vector<int> free;
+    for(int c=0;c<rows*cols;c++) if (grid[c]==0) free.push_back(c);
+    if (free.empty()) return;
+
+    for(int i=0;i<n;i++)
+    {
+      int c = free[rand()%free.size()];
+      x.push_back(c%cols*ts + rand()%ts); y.push_back(c/cols*ts + rand()%ts);
+      int vx, vy;
+      do {vx=4-rand()%8; vy=4-rand()%8;} while (vx==0 || vy==0);
+      dx.push_back(vx); dy.push_back(vy);
+    }
+  }
+
+  int cell(int i, int cols) {return y[i]/ts*cols + x[i]/ts;}
+
+  // a step bounces back when it would cross the wall boundary the distance
+  // field gives for the current cell, same result as testing the new cell
+  void move(const Walls &w, int a, int b)
+  {
+    for(int i=a;i<b;i++)
+    {
+      int cx=x[i]/ts, cy=y[i]/ts, c=cy*w.cols+cx;
+      int nx=x[i]+dx[i];
+      if (dx[i]>0 ? nx >= (cx+w.right[c])*ts : nx < (cx-w.left[c]+1)*ts) dx[i]=-dx[i];
+      else x[i]=nx;
+
+      cx=x[i]/ts; c=cy*w.cols+cx;
+      int ny=y[i]+dy[i];
+      if (dy[i]>0 ? ny >= (cy+w.down[c])*ts : ny < (cy-w.up[c]+1)*ts) dy[i]=-dy[i];
+      else y[i]=ny;
+    }
+  }
+
+  // moves everyone in parallel batches, true if anybody is on the trail
+  template<class Trail> bool update(Jobs &jobs, const Walls &w, const Trail &onTrail)
+  {
+    std::atomic<bool> hit(false);
+    jobs.run(size(), 256, [&](int a,int b)
+     {
+       move(w,a,b);
+       for(int i=a;i<b;i++)
+         if (onTrail(y[i]/ts*w.cols + x[i]/ts)) hit=true;
+     });
+    return hit;
+  }
+};
+
+#endif
@@ -0,0 +1,41 @@
+#ifndef FILL_H
+#define FILL_H
+
+#include <vector>
+
+// Marks every 0 cell reachable from any of the seed cells (y*cols+x) as -1,
+// 4-connected, like the old recursive drop() but with all enemies filled in
+// one pass. Scanline fill: each step paints a whole horizontal run and pushes
+// one seed per run of empty cells found above and below it, so the explicit
+// stack stays small and no cell is painted twice.
+//
+// The game's captures go through Territory, which only falls back to this
+// when a capture grows past its fullFill share of the board; bench.cpp also
+// uses it as the baseline every capture is checked and timed against.
+inline void fill(int *grid, int rows, int cols, const std::vector<int> &seeds)
+{
+  std::vector<int> stack(seeds);
+
+  while(!stack.empty())
+  {
+    int c = stack.back(); stack.pop_back();
+    int y = c/cols, x = c%cols;
+    int *row = grid + y*cols;
+    if (row[x]!=0) continue;
+
+    int l=x, r=x;
+    while (l>0 && row[l-1]==0) l--;
+    while (r<cols-1 && row[r+1]==0) r++;
+    for(int i=l;i<=r;i++) row[i]=-1;
+
+    for(int ny=y-1; ny<=y+1; ny+=2)
+    {
+      if (ny<0 || ny>=rows) continue;
+      int *next = grid + ny*cols;
+      for(int i=l;i<=r;i++)
+        if (next[i]==0 && (i==l || next[i-1]!=0)) stack.push_back(ny*cols+i);
+    }
+  }
+}
+
+#endif
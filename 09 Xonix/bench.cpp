@@ -0,0 +1,126 @@
+// Capture timing:
+//   g++ -std=c++11 -O2 bench.cpp -o bench && ./bench
+// First the fill on its own: the board is walled in with a few captured
+// blocks and a trail across it, enemies are scattered in the open part.
+// Then a whole capture of a corner on a 2000x2000 board, fill and relabel
+// of every cell against Territory: growing regions from the trail only, and
+// as the game runs it, switching to the fill past Territory::fullFill of the
+// board. Each is the best of three runs; "wrong" counts cells where a
+// capture disagrees with the fill.
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+#include "Fill.hpp"
+#include "Territory.hpp"
+
+int rows, cols;
+std::vector<int> grid;
+
+void drop(int y,int x) //the recursive fill the game used to have
+{
+  int *g = &grid[0];
+  if (g[y*cols+x]==0) g[y*cols+x]=-1;
+  if (g[(y-1)*cols+x]==0) drop(y-1,x);
+  if (g[(y+1)*cols+x]==0) drop(y+1,x);
+  if (g[y*cols+x-1]==0) drop(y,x-1);
+  if (g[y*cols+x+1]==0) drop(y,x+1);
+}
+
+void board(int M, int N, std::mt19937 &rnd)
+{
+  rows=M; cols=N;
+  grid.assign(M*N, 0);
+  for(int i=0;i<M;i++)
+   for(int j=0;j<N;j++)
+    if (i==0 || j==0 || i==M-1 || j==N-1) grid[i*N+j]=1;
+
+  std::uniform_int_distribution<int> ry(1,M-2), rx(1,N-2);
+  for(int k=0;k<20;k++)
+  {
+    int y=ry(rnd), x=rx(rnd), h=M/10, w=N/10;
+    for(int i=y;i<y+h && i<M-1;i++)
+     for(int j=x;j<x+w && j<N-1;j++) grid[i*N+j]=1;
+  }
+  for(int i=1;i<M-1;i++) grid[i*N+N/3]=2;   //trail
+}
+
+std::vector<int> enemies(int n, std::mt19937 &rnd)
+{
+  std::uniform_int_distribution<int> ry(1,rows-2), rx(1,cols-2);
+  std::vector<int> seeds;
+  while (int(seeds.size())<n)
+  {
+    int c = ry(rnd)*cols + rx(rnd);
+    if (grid[c]==0) seeds.push_back(c);
+  }
+  return seeds;
+}
+
+template<class F> double ms(F f)
+{
+  auto t0 = std::chrono::steady_clock::now();
+  f();
+  return std::chrono::duration<double,std::milli>(std::chrono::steady_clock::now()-t0).count();
+}
+
+int main()
+{
+  std::mt19937 rnd(1);
+  std::printf("%10s %8s %12s %12s\n", "board", "enemies", "scanline ms", "recursive ms");
+
+  for(int size: {40, 100, 250, 500, 1000, 2000})
+   for(int n: {4, 64})
+   {
+     board(size, size, rnd);
+     std::vector<int> seeds = enemies(n, rnd), saved = grid;
+
+     double s = ms([&]{ fill(&grid[0], rows, cols, seeds); });
+
+     // one recursion level per cell: only safe on small boards
+     double r = 0;
+     if (size<=250)
+     {
+       grid = saved;
+       r = ms([&]{ for(int c: seeds) drop(c/cols, c%cols); });
+     }
+     std::printf("%4dx%-5d %8d %12.3f %12.3f\n", rows, cols, n, s, r);
+   }
+
+  std::printf("\n%9s %8s %16s %12s %14s %6s\n", "corner", "board", "fill+relabel ms", "growing ms", "territory ms", "wrong");
+  for(int k: {10, 100, 250, 400, 500, 700, 1000, 1500})
+  {
+    const int S=2000;
+    std::vector<int> seeds;
+    while (seeds.size()<16)
+    {
+      int c = (k+1+rnd()%(S-k-2))*S + k+1+rnd()%(S-k-2);
+      seeds.push_back(c);
+    }
+
+    double f=1e9, g=1e9, c=1e9;
+    int wrong=0;
+    for(int rep=0;rep<3;rep++)
+    {
+      std::vector<int> a(S*S), a2(S*S);
+      Territory t(&a[0], S, S), t2(&a2[0], S, S);
+      for(int i=1;i<=k;i++)
+      {
+        t.addTrail(i*S+k); t2.addTrail(i*S+k);
+        if (i<k) {t.addTrail(k*S+i); t2.addTrail(k*S+i);}
+      }
+      rows=cols=S; grid=a;
+
+      f = std::min(f, ms([&]{
+        fill(&grid[0], S, S, seeds);
+        for(auto &v: grid) v = v==-1 ? 0 : 1;
+      }));
+      t.fullFill = 2;   //never
+      g = std::min(g, ms([&]{ t.close(seeds); }));
+      c = std::min(c, ms([&]{ t2.close(seeds); }));
+      for(int i=0;i<S*S;i++) wrong += (a[i]!=grid[i]) + (a2[i]!=grid[i]);
+    }
+    std::printf("%4dx%-4d %7.1f%% %16.3f %12.3f %14.3f %6d\n", k, k, 100.0*k*k/(S*S), f, g, c, wrong);
+  }
+  return 0;
+}
@@ -1,5 +1,8 @@
 #include <SFML/Graphics.hpp>
 #include <time.h>
+#include <cmath>
+#include "Territory.hpp"
+#include "Enemies.hpp"
 using namespace sf;
 
 const int M = 25;
@@ -8,33 +11,7 @@ const int N = 40;
 int grid[M][N] = {0};
 int ts = 18; //tile size
 
-struct Enemy
-{int x,y,dx,dy;
-
-  Enemy()
-   {
-	x=y=300;
-    dx=4-rand()%8;
-    dy=4-rand()%8;
-   }
-
-  void move()
-   { 
-    x+=dx; if (grid[y/ts][x/ts]==1) {dx=-dx; x+=dx;}
-    y+=dy; if (grid[y/ts][x/ts]==1) {dy=-dy; y+=dy;}
-   }
-};
-
-void drop(int y,int x)
-{
-  if (grid[y][x]==0) grid[y][x]=-1;
-  if (grid[y-1][x]==0) drop(y-1,x);
-  if (grid[y+1][x]==0) drop(y+1,x);
-  if (grid[y][x-1]==0) drop(y,x-1);
-  if (grid[y][x+1]==0) drop(y,x+1);
-}
-
-int main()
+int main(int argc, char *argv[])
 {
     srand(time(0));
 
@@ -46,21 +23,30 @@ int main()
     t2.loadFromFile("images/gameover.png");
     t3.loadFromFile("images/enemy.png");
 
-	Sprite sTile(t1), sGameover(t2), sEnemy(t3);
+	Sprite sTile(t1), sGameover(t2);
 	sGameover.setPosition(100,100);
-	sEnemy.setOrigin(20,20);
 
-	int enemyCount = 4;
-    Enemy a[10];
+	Enemies enemies(ts);
+	VertexArray enemyQuads(Quads);
+	float angle = 0;
+    Jobs jobs;
+    float goal = 0.75; //captured part of the field to clear a level
 
 	bool Game=true;
 	int x=0, y=0, dx=0, dy=0;
     float timer=0, delay=0.07; 
     Clock clock;
 
-	for (int i=0;i<M;i++)
-	 for (int j=0;j<N;j++)
-      if (i==0 || j==0 || i==M-1 || j==N-1)  grid[i][j]=1;
+	Territory territory(&grid[0][0], M, N);
+	Walls walls(&grid[0][0], M, N);
+	enemies.spawn(argc>1 ? atoi(argv[1]) : 4, &grid[0][0], M, N); //swarm levels: pass the enemy count
+	int shown = -1; //percentage in the title
+
+	RenderTexture board; //filled cells and trail, only dirty rows are redrawn
+	board.create(N*ts, M*ts);
+	Sprite sBoard(board.getTexture());
+	RectangleShape blank(Vector2f(N*ts, ts));
+	blank.setFillColor(Color::Black);
 
     while (window.isOpen())
     {
@@ -77,9 +63,7 @@ int main()
 			if (e.type == Event::KeyPressed)
              if (e.key.code==Keyboard::Escape)
                {
-                for (int i=1;i<M-1;i++)
-	             for (int j=1;j<N-1;j++)
-                   grid[i][j]=0;
+                territory.reset();
 
                 x=10;y=0;
                 Game=true;
@@ -102,51 +86,83 @@ int main()
          if (y<0) y=0; if (y>M-1) y=M-1;
 
 		 if (grid[y][x]==2) Game=false;
-         if (grid[y][x]==0) grid[y][x]=2;
+         if (grid[y][x]==0) territory.addTrail(y*N+x);
          timer=0;
 		}
 
-		for (int i=0;i<enemyCount;i++) a[i].move();
+		bool hit = enemies.update(jobs, walls, [&](int c){return territory.onTrail(c);});
 
 		if (grid[y][x]==1)
           {
            dx=dy=0;
 
-           for (int i=0;i<enemyCount;i++)
-                drop(a[i].y/ts, a[i].x/ts);
+           if (!territory.trail.empty())
+            {
+             std::vector<int> cells;
+             for (int i=0;i<enemies.size();i++)
+                  cells.push_back(enemies.cell(i,N));
+             territory.close(cells);
+            }
+          }
 
-           for (int i=0;i<M;i++)
-	 	    for (int j=0;j<N;j++)
-              if (grid[i][j]==-1) grid[i][j]=0;
-              else grid[i][j]=1;
+        if (territory.captured()>=goal) //next level
+          {
+           territory.reset();
+           enemies.spawn(1, &grid[0][0], M, N);
+           x=y=dx=dy=0;
           }
 
-        for (int i=0;i<enemyCount;i++)
-           if  (grid[a[i].y/ts][a[i].x/ts]==2) Game=false;
+        if (hit && !territory.trail.empty()) Game=false; //trail wasn't just closed
+
+        for (int i: territory.dirtyRows) walls.row(i); //refresh the distance fields a capture changed
+        for (int j: territory.dirtyCols) {walls.col(j); territory.dirtyCol[j]=0;}
+        territory.dirtyCols.clear();
 
       /////////draw//////////
       window.clear();
 
-	  for (int i=0;i<M;i++)
-		for (int j=0;j<N;j++)
+	  for (int i: territory.dirtyRows)
+		{
+		 blank.setPosition(0,i*ts);
+		 board.draw(blank);
+		 for (int j=0;j<N;j++)
 		 {
             if (grid[i][j]==0) continue;
             if (grid[i][j]==1) sTile.setTextureRect(IntRect( 0,0,ts,ts));
             if (grid[i][j]==2) sTile.setTextureRect(IntRect(54,0,ts,ts));
 			sTile.setPosition(j*ts,i*ts);
-			window.draw(sTile);
+			board.draw(sTile);
 		 }
+		 territory.dirty[i]=0;
+		}
+	  if (!territory.dirtyRows.empty()) board.display();
+	  territory.dirtyRows.clear();
+	  window.draw(sBoard);
+
+      int percent = territory.captured()*100;
+      if (percent!=shown)
+        {window.setTitle("Xonix Game! "+std::to_string(percent)+"% of "+std::to_string(int(goal*100))+"%"); shown=percent;}
+
+      RectangleShape bar(Vector2f(N*ts*territory.captured()/goal, 4)); //progress to the next level
+      bar.setFillColor(Color::Green);
+      window.draw(bar);
 
       sTile.setTextureRect(IntRect(36,0,ts,ts));
 	  sTile.setPosition(x*ts,y*ts);
 	  window.draw(sTile);
 
-	  sEnemy.rotate(10);
-      for (int i=0;i<enemyCount;i++)
-       {
-	    sEnemy.setPosition(a[i].x,a[i].y);
-	    window.draw(sEnemy);
-       }
+	  angle += 10; //all enemies spin together, one draw call for the lot
+	  float ca = std::cos(angle*3.14159f/180)*20, sa = std::sin(angle*3.14159f/180)*20;
+	  const float cx[4] = {-1,1,1,-1}, cy[4] = {-1,-1,1,1};
+	  enemyQuads.resize(enemies.size()*4);
+      for (int i=0;i<enemies.size();i++)
+       for (int k=0;k<4;k++)
+        {
+         Vertex &v = enemyQuads[i*4+k];
+         v.position = Vector2f(enemies.x[i] + cx[k]*ca - cy[k]*sa, enemies.y[i] + cx[k]*sa + cy[k]*ca);
+         v.texCoords = Vector2f((cx[k]+1)*20, (cy[k]+1)*20);
+        }
+	  window.draw(enemyQuads, &t3);
 
       if (!Game) window.draw(sGameover);
 
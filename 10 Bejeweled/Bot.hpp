@@ -0,0 +1,108 @@
+#ifndef BOT_H
+#define BOT_H
+
+#include <vector>
+#include <cmath>
+#include <chrono>
+#include <cstdint>
+#include "Match3.hpp"
+#include "../common/Jobs.hpp"
+#include "../common/Random.hpp"
+
+struct MoveScore {GemMove move; double mean, err;}; //gems removed per rollout, standard error of the mean
+
+struct BotResult
+{
+  std::vector<MoveScore> moves;
+  int best;                     //index into moves, -1 when the board is stuck
+  double confidence;            //chance the best mean really beats the runner-up
+  long long rollouts;
+  double seconds;
+};
+
+// Monte Carlo lookahead: every legal swap is tried `rollouts` times on a
+// copy of the board, each followed by `depth` random legal swaps; the
+// score is all gems removed on the way, refills included. Every rollout
+// draws its own seed from (seed, turn, move, rollout), so results don't
+// depend on the thread count or on which thread ran what.
+struct Bot
+{
+  Jobs &jobs;
+  int rollouts, depth;
+  uint64_t seed;
+  int turn;
+
+  Bot(Jobs &j, int R=1000, int D=3, uint64_t s=1) : jobs(j), rollouts(R), depth(D), seed(s), turn(0) {}
+
+  double rollout(Match3Board &b, const GemMove &m, uint64_t key, std::vector<GemEvent> &ev, std::vector<GemMove> &legal)
+  {
+    b.seed = uint32_t(splitmix(key)) | 1;
+    ev.clear();
+    int total = b.swap(m.row, m.col, m.row+m.down, m.col+!m.down, ev);
+    for(int d=0;d<depth;d++)
+    {
+      legal.clear();
+      b.moves(legal);
+      if (legal.empty()) break;  //stuck: nothing more to score
+      const GemMove &g = legal[b.random()%legal.size()];
+      ev.clear();
+      total += b.swap(g.row, g.col, g.row+g.down, g.col+!g.down, ev);
+    }
+    return total;
+  }
+
+  BotResult think(const Match3Board &board)
+  {
+    auto t0 = std::chrono::steady_clock::now();
+    BotResult res;
+    std::vector<GemMove> cand;
+    Match3Board probe = board;
+    probe.moves(cand);
+
+    int n = cand.size(), total = n*rollouts;
+    std::vector<float> score(total);
+    uint64_t base = splitmix(seed ^ splitmix(turn++));
+
+    jobs.run(total, 64, [&](int a,int b)
+     {
+       Match3Board copy = board;
+       std::vector<GemEvent> ev;
+       std::vector<GemMove> legal;
+       for(int t=a;t<b;t++)
+       {
+         copy.kind = board.kind; copy.bits = board.bits;  //same sizes, no allocation
+         score[t] = rollout(copy, cand[t/rollouts], base + t, ev, legal);
+       }
+     });
+
+    res.best=-1; res.confidence=0;
+    for(int i=0;i<n;i++)
+    {
+      double s=0, s2=0;
+      for(int r=0;r<rollouts;r++) {double x=score[i*rollouts+r]; s+=x; s2+=x*x;}
+      MoveScore ms;
+      ms.move = cand[i];
+      ms.mean = s/rollouts;
+      ms.err = rollouts>1 ? std::sqrt(std::max(0.0, s2/rollouts - ms.mean*ms.mean)/(rollouts-1)) : 0;
+      res.moves.push_back(ms);
+      if (res.best<0 || ms.mean > res.moves[res.best].mean) res.best=i;
+    }
+
+    if (n==1) res.confidence=1;
+    if (n>1)
+    {
+      int second=-1;
+      for(int i=0;i<n;i++)
+        if (i!=res.best && (second<0 || res.moves[i].mean > res.moves[second].mean)) second=i;
+      const MoveScore &a=res.moves[res.best], &b=res.moves[second];
+      double gap = a.mean-b.mean, err = std::sqrt(a.err*a.err + b.err*b.err);
+      res.confidence = err>0 ? 0.5*std::erfc(-gap/err/std::sqrt(2.0)) : (gap>0 ? 1 : 0.5);
+    }
+
+    res.rollouts = total;
+    res.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now()-t0).count();
+    return res;
+  }
+};
+
+#endif
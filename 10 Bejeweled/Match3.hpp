@@ -0,0 +1,303 @@
+#ifndef MATCH3_H
+#define MATCH3_H
+
+#include <vector>
+#include <cstdint>
+#include <cstdlib>
+#include <cassert>
+#include <algorithm>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// What happened to the board, in order. Cells are (row,col) from the top
+// left, 0-based; rows above the board are negative.
+struct GemEvent
+{
+  enum Type {Swap, SwapBack, Match, Remove, Fall, Spawn} type;
+  int row, col, row2, col2; //Swap/SwapBack: the two cells, Match: first and last cell of the run,
+                            //Fall: from (row,col) to (row2,col2), Spawn: cell and the row it drops from
+  int kind, step;           //step: cascade number, 0 for the matches the swap itself made
+};
+
+inline int lowBit(uint64_t x)
+{
+#ifdef _MSC_VER
+  unsigned long i; _BitScanForward64(&i, x); return i;
+#else
+  return __builtin_ctzll(x);
+#endif
+}
+
+inline int bitCount(uint64_t x)
+{
+#ifdef _MSC_VER
+  return int(__popcnt64(x));
+#else
+  return __builtin_popcountll(x);
+#endif
+}
+
+// W*64 cells, cell i is bit i%64 of word i/64. Shifting left moves cells
+// towards higher indices: right, or down by a row when shifted by cols.
+template<int W> struct Bits
+{
+  uint64_t w[W];
+
+  Bits() {for(int i=0;i<W;i++) w[i]=0;}
+
+  bool test(int i) const {return w[i>>6]>>(i&63) & 1;}
+  void set(int i) {w[i>>6] |= 1ull<<(i&63);}
+  void clear(int i) {w[i>>6] &= ~(1ull<<(i&63));}
+
+  Bits operator&(const Bits &b) const {Bits r; for(int i=0;i<W;i++) r.w[i]=w[i]&b.w[i]; return r;}
+  Bits operator|(const Bits &b) const {Bits r; for(int i=0;i<W;i++) r.w[i]=w[i]|b.w[i]; return r;}
+  Bits andNot(const Bits &b) const {Bits r; for(int i=0;i<W;i++) r.w[i]=w[i]&~b.w[i]; return r;}
+  Bits& operator|=(const Bits &b) {for(int i=0;i<W;i++) w[i]|=b.w[i]; return *this;}
+
+  Bits operator<<(int k) const
+  {
+    Bits r; int q=k>>6, s=k&63;
+    for(int i=W-1;i>=q;i--)
+      r.w[i] = w[i-q]<<s | (s && i-q-1>=0 ? w[i-q-1]>>(64-s) : 0);
+    return r;
+  }
+
+  Bits operator>>(int k) const
+  {
+    Bits r; int q=k>>6, s=k&63;
+    for(int i=0;i+q<W;i++)
+      r.w[i] = w[i+q]>>s | (s && i+q+1<W ? w[i+q+1]<<(64-s) : 0);
+    return r;
+  }
+
+  bool any() const {for(int i=0;i<W;i++) if (w[i]) return true; return false;}
+  int count() const {int n=0; for(int i=0;i<W;i++) n+=bitCount(w[i]); return n;}
+
+  // removes and returns the lowest cell, -1 when empty
+  int pop()
+  {
+    for(int i=0;i<W;i++)
+      if (w[i]) {int b=lowBit(w[i]); w[i]&=w[i]-1; return i*64+b;}
+    return -1;
+  }
+};
+
+// swap of (row,col) with its right neighbour, or with the one below when down is set
+struct GemMove {int row, col; bool down;};
+
+// The rules without any drawing: swap two gems, remove runs of three or
+// more, let the rest fall and refill from the top until nothing matches.
+// It has its own random generator so it can run headless and reproducibly.
+//
+// Next to the kind of every cell there is one bitboard per kind, so runs
+// and the swaps that would make one are found with shifts and ANDs over
+// the whole board at once. Boards hold up to 64*W cells.
+template<int W> struct Match3
+{
+  typedef Bits<W> B;
+
+  int rows, cols, kinds;
+  std::vector<int> kind;
+  std::vector<B> bits;          //cells holding each kind
+  B removed;
+  B notLeft, notRight, notLeft2, notRight2;  //board cells except the first/last one or two columns
+  uint32_t seed;
+  long long score;   //gems removed so far
+
+  Match3(int R=8, int C=8, int K=7, uint32_t s=1) : rows(R), cols(C), kinds(K), kind(R*C), bits(K)
+  {
+    assert(R*C <= 64*W && C>=3);
+    for(int r=0;r<rows;r++)
+     for(int c=0;c<cols;c++)
+      {
+        int i=r*cols+c;
+        if (c>0) notLeft.set(i);
+        if (c<cols-1) notRight.set(i);
+        if (c>1) notLeft2.set(i);
+        if (c<cols-2) notRight2.set(i);
+      }
+    seed = s ? s : 1;
+    reset();
+  }
+
+  uint32_t random() {seed^=seed<<13; seed^=seed>>17; seed^=seed<<5; return seed;}
+
+  int at(int r,int c) const {return kind[r*cols+c];}
+
+  void put(int i,int k)
+  {
+    bits[kind[i]].clear(i);
+    kind[i]=k; bits[k].set(i);
+  }
+
+  void rebuild()
+  {
+    for(int k=0;k<kinds;k++) bits[k]=B();
+    for(int i=0;i<rows*cols;i++) bits[kind[i]].set(i);
+  }
+
+  // random board that doesn't start with a match but has a move
+  void reset()
+  {
+    score=0;
+    do
+    {
+      for(int r=0;r<rows;r++)
+       for(int c=0;c<cols;c++)
+        {
+          int k;
+          do k=random()%kinds;
+          while ((c>=2 && at(r,c-1)==k && at(r,c-2)==k) || (r>=2 && at(r-1,c)==k && at(r-2,c)==k));
+          kind[r*cols+c]=k;
+        }
+      rebuild();
+    }
+    while (!hasMove());
+  }
+
+  // first cells of the horizontal and vertical triples of one kind
+  B tripleH(const B &b) {return b & (b>>1) & (b>>2) & notRight2;}
+  B tripleV(const B &b) {return b & (b>>cols) & (b>>(2*cols));}
+
+  // one Match event per run; `step` is 1 for triples along rows, cols for columns
+  void runs(B starts, int step, int k, int ev, std::vector<GemEvent> &out)
+  {
+    B first = starts.andNot(starts<<step);
+    for(int i=first.pop(); i>=0; i=first.pop())
+    {
+      int e=i;
+      while (e+step<rows*cols && starts.test(e+step)) e+=step;
+      e+=2*step;
+      GemEvent m = {GemEvent::Match, i/cols, i%cols, e/cols, e%cols, k, ev};
+      out.push_back(m);
+    }
+  }
+
+  // marks every cell in a run of 3+ once, returns how many were marked
+  int findMatches(std::vector<GemEvent> &out, int step)
+  {
+    removed = B();
+    for(int k=0;k<kinds;k++)
+    {
+      const B &b = bits[k];
+      B h = tripleH(b), v = tripleV(b);
+      if (!h.any() && !v.any()) continue;
+      removed |= h | (h<<1) | (h<<2) | v | (v<<cols) | (v<<(2*cols));
+      runs(h, 1, k, step, out);
+      runs(v, cols, k, step, out);
+    }
+    return removed.count();
+  }
+
+  // removed gems go, the ones above fall into place, new ones drop in from the top
+  void collapse(std::vector<GemEvent> &out, int step)
+  {
+    B rem = removed;
+    for(int i=rem.pop(); i>=0; i=rem.pop())
+      {GemEvent e = {GemEvent::Remove, i/cols, i%cols, i/cols, i%cols, kind[i], step}; out.push_back(e);}
+
+    for(int c=0;c<cols;c++)
+    {
+      int w=rows-1;
+      for(int r=rows-1;r>=0;r--)
+        if (!removed.test(r*cols+c))
+        {
+          if (r!=w)
+          {
+            kind[w*cols+c]=kind[r*cols+c];
+            GemEvent e = {GemEvent::Fall, r, c, w, c, kind[w*cols+c], step}; out.push_back(e);
+          }
+          w--;
+        }
+      for(int r=w;r>=0;r--)
+      {
+        kind[r*cols+c]=random()%kinds;
+        GemEvent e = {GemEvent::Spawn, r, c, r-w-1, c, kind[r*cols+c], step}; out.push_back(e);
+      }
+    }
+    removed = B();
+    rebuild();
+  }
+
+  // runs the cascade to the end, returns the number of gems removed
+  int settle(std::vector<GemEvent> &out)
+  {
+    int total=0;
+    for(int step=0;;step++)
+    {
+      int n = findMatches(out, step);
+      if (!n) break;
+      collapse(out, step);
+      total+=n;
+    }
+    score+=total;
+    return total;
+  }
+
+  // Every swap that makes a match, as the left cell of horizontal swaps
+  // and the top cell of vertical ones. A gem of kind k moving into cell x
+  // matches when x has two more k's in line with it, not counting the cell
+  // the gem came from; so for each kind the cells a k can move into are
+  // ANDed with the patterns around them, no swap is actually tried.
+  void moveSets(B &right, B &down)
+  {
+    right = B(); down = B();
+    for(int k=0;k<kinds;k++)
+    {
+      const B &b = bits[k];
+      B r2 = (b>>1) & (b>>2) & notRight2,          //two k's to the right of x
+        l2 = (b<<1) & (b<<2) & notLeft2,           //two to the left
+        hm = (b<<1) & (b>>1) & notLeft & notRight, //one on each side
+        d2 = (b>>cols) & (b>>(2*cols)),
+        u2 = (b<<cols) & (b<<(2*cols)),
+        vm = (b<<cols) & (b>>cols);
+
+      right |= (((b & notRight)<<1) & (r2|u2|d2|vm)) >> 1; //k moves right
+      right |= ((b & notLeft)>>1) & (l2|u2|d2|vm);         //k moves left
+      down  |= ((b<<cols) & (d2|l2|r2|hm)) >> cols;        //k moves down
+      down  |= (b>>cols) & (u2|l2|r2|hm);                  //k moves up
+    }
+  }
+
+  bool hasMove()
+  {
+    B right, down;
+    moveSets(right, down);
+    return right.any() || down.any();
+  }
+
+  void moves(std::vector<GemMove> &out)
+  {
+    B right, down;
+    moveSets(right, down);
+    for(int i=right.pop(); i>=0; i=right.pop()) {GemMove m = {i/cols, i%cols, false}; out.push_back(m);}
+    for(int i=down.pop(); i>=0; i=down.pop()) {GemMove m = {i/cols, i%cols, true}; out.push_back(m);}
+  }
+
+  // swaps two neighbouring gems; without a match they swap back and the
+  // board is unchanged. Returns gems removed, -1 if the cells aren't neighbours.
+  int swap(int r1,int c1,int r2,int c2, std::vector<GemEvent> &out)
+  {
+    if (r1<0 || r2<0 || c1<0 || c2<0 || r1>=rows || r2>=rows || c1>=cols || c2>=cols) return -1;
+    if (abs(r1-r2)+abs(c1-c2)!=1) return -1;
+
+    GemEvent s = {GemEvent::Swap, r1, c1, r2, c2, 0, 0};
+    out.push_back(s);
+    int a=r1*cols+c1, b=r2*cols+c2, ka=kind[a], kb=kind[b];
+    put(a,kb); put(b,ka);
+
+    int n = settle(out);
+    if (!n)
+    {
+      put(a,ka); put(b,kb);
+      s.type = GemEvent::SwapBack;
+      out.push_back(s);
+    }
+    return n;
+  }
+};
+
+typedef Match3<1> Match3Board;
+
+#endif
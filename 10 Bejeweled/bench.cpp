@@ -0,0 +1,76 @@
+// Headless play timing:
+//   g++ -std=c++11 -O2 bench.cpp -o bench && ./bench [moves] [seed]
+// Random neighbouring swaps on an 8x8 board with 7 kinds, cascades played
+// to the end, a new board whenever no move is left. Checks along the way
+// that no settled board still holds a match. Then the same with only the
+// swaps the move generator lists, and the generator on its own.
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include "Match3.hpp"
+
+double since(std::chrono::steady_clock::time_point t0)
+{
+  return std::chrono::duration<double>(std::chrono::steady_clock::now()-t0).count();
+}
+
+int main(int argc, char *argv[])
+{
+  long long moves = argc>1 ? atoll(argv[1]) : 2000000;
+  Match3Board board(8, 8, 7, argc>2 ? atoi(argv[2]) : 1);
+  std::vector<GemEvent> events, check;
+  std::vector<GemMove> legal;
+
+  long long made=0, removed=0, cascades=0, eventCount=0, stuck=0, bad=0;
+  auto t0 = std::chrono::steady_clock::now();
+  for(long long m=0;m<moves;m++)
+  {
+    int r=board.random()%8, c=board.random()%8, down=board.random()%2;
+    if (down ? r==7 : c==7) continue;
+
+    events.clear();
+    int n = board.swap(r, c, r+down, c+!down, events);
+    eventCount += events.size();
+    if (n>0) {made++; removed+=n; cascades+=events.back().step+1;}
+
+    if ((m&1023)==0) {check.clear(); if (board.findMatches(check,0)) {bad++; board.collapse(check,0);}}
+    if (!board.hasMove()) {stuck++; board.reset();}
+  }
+  double t = since(t0);
+
+  printf("random swaps: %lld in %.2fs, %.2fM/s\n", moves, t, moves/t/1e6);
+  printf("  %lld matched (%.1f%%), %.2f gems and %.2f cascade steps per match\n",
+         made, 100.0*made/moves, made ? double(removed)/made : 0, made ? double(cascades)/made : 0);
+  printf("  %.1f events per swap, %lld stuck boards, %lld bad boards\n", double(eventCount)/moves, stuck, bad);
+
+  long long options=0, failed=0; stuck=0;
+  t0 = std::chrono::steady_clock::now();
+  for(long long m=0;m<moves;m++)
+  {
+    legal.clear();
+    board.moves(legal);
+    if (legal.empty()) {stuck++; board.reset(); continue;}
+    options += legal.size();
+    GemMove g = legal[board.random()%legal.size()];
+    events.clear();
+    if (board.swap(g.row, g.col, g.row+g.down, g.col+!g.down, events)<=0) failed++;
+  }
+  t = since(t0);
+  printf("listed moves: %lld in %.2fs, %.2fM/s\n", moves, t, moves/t/1e6);
+  printf("  %.2f moves per board, %lld stuck boards, %lld listed moves that didn't match\n",
+         double(options)/moves, stuck, failed);
+
+  long long found=0;
+  t0 = std::chrono::steady_clock::now();
+  for(long long m=0;m<moves;m++)
+  {
+    legal.clear();
+    board.moves(legal);
+    found += legal.size();
+    board.put(m%64, (board.kind[m%64]+1)%7);  //vary the board a little, it needn't be settled
+  }
+  t = since(t0);
+  printf("move generator: %.1fM boards/s (%lld moves)\n", moves/t/1e6, found);
+  return bad!=0 || failed!=0;
+}
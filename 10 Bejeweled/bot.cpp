@@ -0,0 +1,50 @@
+// Monte Carlo bot playing headless games, to see how hard a board setup is:
+//   g++ -std=c++11 -O2 -pthread bot.cpp -o bot
+//   ./bot [turns=30] [rollouts=2000] [depth=3] [kinds=7] [seed=1] [threads=all]
+// Prints every turn's pick with its mean score and how sure the bot is
+// about it, then the totals. Fewer moves per turn, lower means and more
+// stuck boards make for a harder setup.
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include "Bot.hpp"
+
+int main(int argc, char *argv[])
+{
+  int turns    = argc>1 ? atoi(argv[1]) : 30;
+  int rollouts = argc>2 ? atoi(argv[2]) : 2000;
+  int depth    = argc>3 ? atoi(argv[3]) : 3;
+  int kinds    = argc>4 ? atoi(argv[4]) : 7;
+  int seed     = argc>5 ? atoi(argv[5]) : 1;
+  int threads  = argc>6 ? atoi(argv[6]) : std::thread::hardware_concurrency();
+
+  Jobs jobs(threads);
+  Bot bot(jobs, rollouts, depth, seed);
+  Match3Board board(8, 8, kinds, seed);
+  std::vector<GemEvent> events;
+
+  long long allRollouts=0, options=0, score=0;
+  double time=0, sure=0;
+  int stuck=0;
+  for(int t=0;t<turns;t++)
+  {
+    BotResult r = bot.think(board);
+    allRollouts += r.rollouts; time += r.seconds;
+    if (r.best<0) {printf("%3d  stuck, new board\n", t); stuck++; board.reset(); continue;}
+
+    const MoveScore &m = r.moves[r.best];
+    options += r.moves.size(); sure += r.confidence;
+    events.clear();
+    int got = board.swap(m.move.row, m.move.col, m.move.row+m.move.down, m.move.col+!m.move.down, events);
+    score += got;
+    printf("%3d  %2d moves  best (%d,%d)%s  mean %.2f +- %.2f  sure %3.0f%%  got %2d  %.2fM rollouts/s\n",
+           t, int(r.moves.size()), m.move.row, m.move.col, m.move.down ? "v" : ">",
+           m.mean, m.err, 100*r.confidence, got, r.rollouts/r.seconds/1e6);
+  }
+
+  int played = turns-stuck;
+  printf("\nscore %lld in %d turns, %d stuck boards\n", score, turns, stuck);
+  if (played) printf("%.2f moves per turn, %.0f%% average confidence\n", double(options)/played, 100*sure/played);
+  printf("%lld rollouts in %.2fs on %d threads: %.2fM rollouts/s\n", allRollouts, time, threads, allRollouts/time/1e6);
+  return 0;
+}
@@ -1,5 +1,6 @@
 #include <SFML/Graphics.hpp>
 #include <time.h>
+#include "Match3.hpp"
 using namespace sf;
 
 int ts = 54; //tile size
@@ -18,6 +19,20 @@ void swap(piece p1,piece p2)
   grid[p1.row][p1.col]=p1;
   grid[p2.row][p2.col]=p2;
 }
+
+void show(Match3Board &board)
+{
+	for (int i=1;i<=8;i++)
+     for (int j=1;j<=8;j++)
+      {
+          grid[i][j]=piece();
+          grid[i][j].kind=board.at(i-1,j-1);
+          grid[i][j].col=j;
+          grid[i][j].row=i;
+          grid[i][j].x = j*ts;
+          grid[i][j].y = i*ts;
+      }
+}
 
 
 int main()
@@ -33,18 +48,18 @@ int main()
 
     Sprite background(t1), gems(t2);
 
-	for (int i=1;i<=8;i++)
-     for (int j=1;j<=8;j++)
-      {
-          grid[i][j].kind=rand()%3;
-          grid[i][j].col=j;
-          grid[i][j].row=i;
-          grid[i][j].x = j*ts;
-          grid[i][j].y = i*ts;
-      }
+    Match3Board board(8,8,7,rand()); //the rules; grid only shows them
+    show(board);
 
     int x0,y0,x,y; int click=0; Vector2i pos;
-    bool isSwap=false, isMoving=false;
+    bool isMoving=false;
+    std::vector<GemEvent> events; size_t played=0; //what the last swap did, and how much of it is shown
+    std::vector<GemMove> hints; int hint=-1;     //H shows one of the moves that would match
+
+    RectangleShape frame(Vector2f(ts-4,ts-4));
+    frame.setFillColor(Color::Transparent);
+    frame.setOutlineColor(Color::Yellow);
+    frame.setOutlineThickness(2);
 
     while (app.isOpen())
     {
@@ -57,9 +72,16 @@ int main()
 			if (e.type == Event::MouseButtonPressed)
 				if (e.key.code == Mouse::Left)
 				{
-				   if (!isSwap && !isMoving) click++;
+				   if (played==events.size() && !isMoving) click++;
 				   pos = Mouse::getPosition(app)-offset;
-                }
+                }
+
+			if (e.type == Event::KeyPressed)
+				if (e.key.code == Keyboard::H && played==events.size() && !isMoving)
+				{
+				   hints.clear(); board.moves(hints);
+				   if (!hints.empty()) hint = rand()%hints.size();
+                }
          }
 	
    // mouse click
@@ -73,23 +95,10 @@ int main()
       x=pos.x/ts+1;
       y=pos.y/ts+1;
       if (abs(x-x0)+abs(y-y0)==1)
-        {swap(grid[y0][x0],grid[y][x]); isSwap=1; click=0;}
+        {events.clear(); played=0; board.swap(y0-1,x0-1,y-1,x-1,events); click=0; hint=-1;}
       else click=1;
     }
 
-   //Match finding
-   for(int i=1;i<=8;i++)
-   for(int j=1;j<=8;j++)
-   {
-    if (grid[i][j].kind==grid[i+1][j].kind)
-    if (grid[i][j].kind==grid[i-1][j].kind)
-     for(int n=-1;n<=1;n++) grid[i+n][j].match++;
-
-    if (grid[i][j].kind==grid[i][j+1].kind)
-    if (grid[i][j].kind==grid[i][j-1].kind)
-     for(int n=-1;n<=1;n++) grid[i][j+n].match++;
-   }
-
    //Moving animation
    isMoving=false;
    for (int i=1;i<=8;i++)
@@ -111,35 +120,31 @@ int main()
     for (int j=1;j<=8;j++)
     if (grid[i][j].match) if (grid[i][j].alpha>10) {grid[i][j].alpha-=10; isMoving=true;}
 
-   //Get score
-   int score=0;
-   for (int i=1;i<=8;i++)
-    for (int j=1;j<=8;j++)
-      score+=grid[i][j].match;
-
-   //Second swap if no match
-   if (isSwap && !isMoving)
-      {if (!score) swap(grid[y0][x0],grid[y][x]); isSwap=0;}
-
-   //Update grid
-   if (!isMoving)
+   //Play back the next group of events once the last animation is over:
+   //swap, swap back, removals (fade), falls and new gems (move)
+   if (!isMoving && played<events.size())
     {
-      for(int i=8;i>0;i--)
-       for(int j=1;j<=8;j++)
-         if (grid[i][j].match)
-         for(int n=i;n>0;n--)
-            if (!grid[n][j].match) {swap(grid[n][j],grid[i][j]); break;};
+      const int group[] = {0,1,2,2,3,3};
+      int g = group[events[played].type];
+      for(; played<events.size() && group[events[played].type]==g; played++)
+       {
+        GemEvent &ev = events[played];
+        int r=ev.row+1, c=ev.col+1, r2=ev.row2+1, c2=ev.col2+1;
+        if (ev.type==GemEvent::Swap || ev.type==GemEvent::SwapBack) swap(grid[r][c],grid[r2][c2]);
+        if (ev.type==GemEvent::Remove) grid[r][c].match=1;
+        if (ev.type==GemEvent::Fall) {piece p=grid[r][c]; p.row=r2; grid[r2][c2]=p;}
+        if (ev.type==GemEvent::Spawn)
+          {
+           piece &p = grid[r][c]; p = piece();
+           p.kind=ev.kind; p.row=r; p.col=c;
+           p.x=c*ts; p.y=r2*ts;
+          }
+       }
+    }
 
-      for(int j=1;j<=8;j++)
-       for(int i=8,n=0;i>0;i--)
-         if (grid[i][j].match)
-           {
-            grid[i][j].kind = rand()%7;
-            grid[i][j].y = -ts*n++;
-            grid[i][j].match=0;
-			grid[i][j].alpha = 255;
-           }
-     }
+   //No move left: new board
+   if (!isMoving && played==events.size() && !board.hasMove())
+    {board.reset(); show(board); events.clear(); played=0; hint=-1;}
 
 
     //////draw///////
@@ -156,6 +161,15 @@ int main()
         app.draw(gems);
       }
 
+    if (hint>=0)
+      for (int n=0;n<2;n++)
+       {
+        GemMove m = hints[hint];
+        int r = m.row + (n && m.down), c = m.col + (n && !m.down);
+        frame.setPosition(offset.x+c*ts+2, offset.y+r*ts+2);
+        app.draw(frame);
+       }
+
      app.display();
     }
     return 0;
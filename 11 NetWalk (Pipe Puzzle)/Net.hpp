@@ -0,0 +1,162 @@
+#ifndef NET_H
+#define NET_H
+
+#include <vector>
+#include <cstdint>
+#include <cstring>
+
+// Every cell is a bit mask of the sides its pipe leaves through.
+// Directions go clockwise, so turning a pipe is a rotate of the mask and
+// the opposite side is half way round.
+enum {Up=1, Right=2, Down=4, Left=8};   //sides of a square cell
+const int dirX[4] = {0,1,0,-1};
+const int dirY[4] = {-1,0,1,0};
+
+inline int rotl(int m) {return ((m<<1)|(m>>3))&15;}   //a quarter turn of a square pipe
+
+inline int pipes(int m) {int n=0; for(;m;m&=m-1) n++; return n;}
+
+// Picture for a square mask in pipes.png: 0 straight, 1 end, 2 elbow, 3 tee
+inline int kindOf(int m)
+{
+  if (m==(Up|Down) || m==(Left|Right)) return 0;
+  return pipes(m);
+}
+
+// pipes.png draws each kind in one position; the sprite is turned by
+// orientation*90 degrees clockwise, the smallest 1..4 that gives the mask
+struct Orientations
+{
+  int n[16];
+
+  Orientations()
+  {
+    const int canonical[4] = {Left|Right, Down, Down|Left, Right|Down|Left};
+    for(int m=0;m<16;m++) n[m]=0;
+    for(int k=0;k<4;k++)
+     for(int i=1,c=canonical[k];i<=4;i++)
+      {
+        c=rotl(c);
+        if (!n[c]) n[c]=i;
+      }
+  }
+};
+
+inline int orientationOf(int m) {static Orientations t; return t.n[m];}
+
+// How cells neighbour each other:
+//  Square: 4 sides, nothing past the edges
+//  Torus:  4 sides, the edges wrap round (needs 3+ cells each way)
+//  Hex:    6 sides NE,E,SE,SW,W,NW; odd rows sit half a cell to the right
+enum Shape {Square, Torus, Hex};
+
+// The board as one contiguous array, row by row, so a whole state copies
+// and hashes as a single block of bytes.
+//
+// Neighbours come from a table built once for the shape. Off the board is
+// cell n, an extra cell past the end with no pipes, so nothing has to test
+// for the edge: a pipe pointing there just never meets another one.
+struct Net
+{
+  int w, h, n, dirs;
+  Shape shape;
+  std::vector<uint8_t> cells;
+  std::vector<int> nb;        //nb[c*dirs+d]: neighbour of c in direction d
+
+  Net(int W=0, int H=0, Shape s=Square) : w(W), h(H), n(W*H), dirs(s==Hex ? 6 : 4), shape(s), cells(W*H+1, 0), nb((W*H+1)*dirs, W*H)
+  {
+    const int evenX[6]={0,1,0,-1,-1,-1}, oddX[6]={1,1,1,0,-1,0}, hexY[6]={-1,0,1,1,0,-1};
+    for(int y=0;y<h;y++)
+     for(int x=0;x<w;x++)
+      for(int d=0;d<dirs;d++)
+       {
+         int nx = x+dirX[d%4], ny = y+dirY[d%4];
+         if (shape==Hex) {nx = x+(y%2 ? oddX[d] : evenX[d]); ny = y+hexY[d];}
+         if (shape==Torus) {nx=(nx+w)%w; ny=(ny+h)%h;}
+         if (!isOut(nx,ny)) nb[index(x,y)*dirs+d] = index(nx,ny);
+       }
+  }
+
+  int index(int x,int y) const {return y*w+x;}
+  bool isOut(int x,int y) const {return x<0 || y<0 || x>=w || y>=h;}
+  int size() const {return n;}
+
+  int all() const {return (1<<dirs)-1;}
+  int opposite(int d) const {return d<dirs/2 ? d+dirs/2 : d-dirs/2;}
+  int turn(int m) const {return ((m<<1)|(m>>(dirs-1))) & all();}   //one step clockwise
+  void rotate(int c) {cells[c]=turn(cells[c]);}
+
+  // neighbour of c in direction d, n off the board
+  int next(int c,int d) const {return nb[c*dirs+d];}
+
+  // pipes of c and its neighbour in direction d meet
+  bool connects(int c,int d) const {return cells[c]>>d & cells[next(c,d)]>>opposite(d) & 1;}
+
+  void copy(const Net &o)
+  {
+    if (o.cells.size()!=cells.size() || o.shape!=shape) *this=o;
+    else memcpy(&cells[0], &o.cells[0], cells.size());
+  }
+
+  uint64_t hash() const   //FNV-1a
+  {
+    uint64_t x=14695981039346656037ull;
+    for(size_t i=0;i<cells.size();i++) {x^=cells[i]; x*=1099511628211ull;}
+    return x;
+  }
+};
+
+// Which cells the server feeds. A cell is powered while on[c]==gen, so a
+// new flood only bumps gen instead of clearing the board, and the flood
+// is a BFS with its own queue instead of recursion.
+//
+// After a turn only what can change is looked at: an unpowered pipe that
+// still doesn't meet a powered one costs nothing, one that now does
+// floods just the cells it brings in, and turning a powered pipe refloods
+// the powered part of the board, never the rest.
+struct Power
+{
+  const Net &net;
+  int source, powered;
+  std::vector<uint32_t> on;
+  uint32_t gen;
+  std::vector<int> queue;
+
+  Power(const Net &n, int src) : net(n), source(src), powered(0), on(n.size()+1, 0), gen(0) {}
+
+  bool isOn(int c) const {return on[c]==gen;}
+  bool solved() const {return powered==net.size();}
+
+  // adds everything reachable from c that isn't powered yet
+  void flood(int c)
+  {
+    queue.clear();
+    queue.push_back(c); on[c]=gen; powered++;
+    for(size_t i=0;i<queue.size();i++)
+    {
+      int v=queue[i];
+      for(int d=0;d<net.dirs;d++)
+        if (net.connects(v,d))
+        {
+          int u=net.next(v,d);
+          if (on[u]!=gen) {on[u]=gen; powered++; queue.push_back(u);}
+        }
+    }
+  }
+
+  void update()
+  {
+    gen++; powered=0;
+    flood(source);
+  }
+
+  // call after the pipe at c turned
+  void rotated(int c)
+  {
+    if (isOn(c)) {update(); return;}
+    for(int d=0;d<net.dirs;d++)
+      if (net.connects(c,d) && isOn(net.next(c,d))) {flood(c); return;}
+  }
+};
+
+#endif
@@ -0,0 +1,332 @@
+#ifndef PUZZLE_H
+#define PUZZLE_H
+
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include <utility>
+#include "Net.hpp"
+#include "../common/Random.hpp"
+
+struct Links   //union-find over cells
+{
+  std::vector<int> parent;
+
+  void reset(int n) {parent.resize(n); for(int i=0;i<n;i++) parent[i]=i;}
+  int find(int c) {while(parent[c]!=c) c=parent[c]=parent[parent[c]]; return c;}
+  bool join(int a,int b) {a=find(a); b=find(b); if (a==b) return false; parent[a]=b; return true;}
+};
+
+// Solved board as a random spanning tree, by randomized Kruskal: every
+// link between neighbours in random order, kept when it joins two
+// separate trees and neither end has 3 pipes yet (pipes.png has no cross).
+// The cap can leave the tree in pieces, then it tries again.
+// Works the same on any Shape, only the neighbour table differs.
+inline void generate(Net &net, uint32_t seed)
+{
+  if (!seed) seed=1;
+  std::vector<int> links;   //cell*dirs+direction, each link once
+  for(int c=0;c<net.size();c++)
+    for(int d=1;d<=net.dirs/2;d++)   //the forward half of the sides
+      if (net.next(c,d)!=net.size()) links.push_back(c*net.dirs+d);
+
+  Links sets;
+  for(;;)
+  {
+    for(int i=links.size()-1;i>0;i--) std::swap(links[i], links[xorshift(seed)%(i+1)]);
+    std::fill(net.cells.begin(), net.cells.end(), 0);
+    sets.reset(net.size());
+
+    int joined=0;
+    for(int l: links)
+    {
+      int c=l/net.dirs, d=l%net.dirs, n=net.next(c,d);
+      if (pipes(net.cells[c])>=3 || pipes(net.cells[n])>=3) continue;
+      if (!sets.join(c,n)) continue;
+      net.cells[c] |= 1<<d;
+      net.cells[n] |= 1<<net.opposite(d);
+      joined++;
+    }
+    if (joined==net.size()-1) return;
+  }
+}
+
+// Moves one link of the tree at cell c somewhere close by: drops a link of
+// c, then joins the two halves again with another link within two cells
+// of c. Used to break up the parts of a puzzle with more than one answer.
+// The halves are walked from both ends at once and only the smaller one
+// is walked to the end, usually a short branch.
+inline bool perturb(Net &tree, int c, uint32_t &seed, std::vector<int> &side, int &stamp)
+{
+  std::vector<int> qa, qb, links, near(1,c);
+  const int dirs=tree.dirs, n=tree.size();
+  for(int r=0,a=0;r<2;r++)   //cells up to two steps from c
+   for(int b=near.size();a<b;a++)
+    for(int e=0;e<dirs;e++)
+     {
+       int v=tree.next(near[a],e);
+       if (v!=n && std::find(near.begin(),near.end(),v)==near.end()) near.push_back(v);
+     }
+
+  int first=xorshift(seed)%dirs;
+  for(int k=0;k<dirs;k++)
+  {
+    int d=(first+k)%dirs, x=tree.next(c,d);
+    if (!(tree.cells[c]>>d&1)) continue;
+    tree.cells[c] &= ~(1<<d); tree.cells[x] &= ~(1<<tree.opposite(d));
+
+    int sa=++stamp, sb=++stamp, done=0;
+    qa.assign(1,c); qb.assign(1,x); side[c]=sa; side[x]=sb;
+    for(size_t i=0;!done;i++)
+      for(int h=0;h<2 && !done;h++)
+      {
+        std::vector<int> &q = h ? qb : qa;
+        int s = h ? sb : sa;
+        if (i>=q.size()) {done=s; break;}
+        for(int e=0;e<dirs;e++)
+          if (tree.cells[q[i]]>>e&1)
+          {
+            int v=tree.next(q[i],e);
+            if (side[v]!=s) {side[v]=s; q.push_back(v);}
+          }
+      }
+
+    links.clear();
+    for(int v: near)
+      for(int e=0;e<dirs;e++)
+      {
+        int u=tree.next(v,e);
+        if (u==n || (side[v]==done)==(side[u]==done)) continue;   //same half
+        if ((v==c && u==x) || (v==x && u==c)) continue;
+        if (pipes(tree.cells[v])>=3 || pipes(tree.cells[u])>=3) continue;
+        links.push_back(v*dirs+e);
+      }
+
+    if (links.empty()) {tree.cells[c] |= 1<<d; tree.cells[x] |= 1<<tree.opposite(d); continue;}
+    int l=links[xorshift(seed)%links.size()], v=l/dirs, e=l%dirs;
+    tree.cells[v] |= 1<<e; tree.cells[tree.next(v,e)] |= 1<<tree.opposite(e);
+    return true;
+  }
+  return false;
+}
+
+inline void scramble(Net &net, uint32_t seed)
+{
+  if (!seed) seed=1;
+  for(int c=0;c<net.size();c++)
+    for(int k=xorshift(seed)%net.dirs;k>0;k--) net.rotate(c);
+}
+
+// Counts the ways to turn the pipes of a puzzle into one tree, up to `limit`.
+//
+// Every cell keeps the set of masks it may still take (bit m of a 64-bit
+// word, hex pipes have 6 sides). Propagation: a side both neighbours must
+// agree on; the off-board cell has no pipes, so nothing points there.
+// On top of that, over the links known to be open: a link inside one
+// group of joined cells would close a loop so it is shut, and a group
+// with a single way out has to take it. A torus has no edges to start
+// from, so there two groups with one free pipe end each can't meet
+// unless that makes the whole board. A loop or a group with no way out
+// left is a dead end. What is left is searched by fixing the cell with
+// the fewest choices, one choice at a time.
+struct Solver
+{
+  int n;
+  const Net *net;
+  std::vector<uint64_t> dom;
+  std::vector<std::pair<int,uint64_t>> trail;   //cells narrowed so far and what they were before
+  std::vector<int> queue;
+  std::vector<char> queued;
+  std::vector<int> exits, exitLink, groupSize, ends;
+  std::vector<char> pipeCount;
+  Links sets;
+  Net solution;
+  int found, limit;
+  long long nodes;
+
+  uint64_t hasSide[6];   //masks that have side d
+
+  Solver() {for(int d=0;d<6;d++) {hasSide[d]=0; for(int m=0;m<64;m++) if (m>>d&1) hasSide[d]|=1ull<<m;}}
+
+  bool open(int c,int d) const {return !(dom[c] & ~hasSide[d]);}
+  bool shut(int c,int d) const {return !(dom[c] & hasSide[d]);}
+
+  void push(int c) {if (!queued[c]) {queued[c]=1; queue.push_back(c);}}
+
+  bool narrow(int c, uint64_t D)
+  {
+    if (D==dom[c]) return true;
+    trail.push_back(std::make_pair(c,dom[c]));
+    dom[c]=D;
+    for(int d=0;d<net->dirs;d++) push(net->next(c,d));
+    return D!=0;
+  }
+
+  // puts back every cell narrowed since the trail was `mark` long
+  void undo(size_t mark)
+  {
+    while (trail.size()>mark) {dom[trail.back().first]=trail.back().second; trail.pop_back();}
+  }
+
+  bool propagate()
+  {
+    for(size_t i=0;i<queue.size();i++)
+    {
+      int c=queue[i]; queued[c]=0;
+      uint64_t D=dom[c];
+      for(int d=0;d<net->dirs;d++)
+      {
+        int x=net->next(c,d), o=net->opposite(d);
+        if (shut(x,o)) D &= ~hasSide[d];
+        else if (open(x,o)) D &= hasSide[d];
+      }
+      if (!narrow(c,D)) {for(size_t j=i+1;j<queue.size();j++) queued[queue[j]]=0; queue.clear(); return false;}
+    }
+    queue.clear();
+    return true;
+  }
+
+  // loops and closed-off groups over the links known so far
+  bool groups()
+  {
+    for(;;)
+    {
+      sets.reset(n+1);
+      for(int c=0;c<n;c++)
+        for(int d=1;d<=net->dirs/2;d++)
+        {
+          int x=net->next(c,d);
+          if (open(c,d) && !sets.join(c,x)) return false;   //loop
+        }
+
+      bool changed=false, forced=false;
+      exits.assign(n,0); exitLink.assign(n,-1);
+      groupSize.assign(n,0); ends.assign(n,0);
+      for(int c=0;c<n;c++) {groupSize[sets.find(c)]++; ends[sets.find(c)]+=pipeCount[c];}
+      for(int c=0;c<n;c++)
+        for(int d=0;d<net->dirs;d++)
+        {
+          int x=net->next(c,d), g=sets.find(c);
+          if (open(c,d)) {ends[g]--; continue;}
+          if (shut(c,d)) continue;
+          if (g==sets.find(x))   //would close a loop
+          {
+            if (!narrow(c, dom[c]&~hasSide[d]) || !narrow(x, dom[x]&~hasSide[net->opposite(d)])) return false;
+            changed=true;
+          }
+          else {exits[g]++; exitLink[g]=c*net->dirs+d;}
+        }
+
+      for(int g=0;g<n && !changed;g++)   //only on settled links
+      {
+        if (sets.find(g)!=g || groupSize[g]==n) continue;
+        if (exits[g]==0) return false;   //cut off from the rest
+        if (exits[g]==1)
+        {
+          int c=exitLink[g]/net->dirs, d=exitLink[g]%net->dirs, x=net->next(c,d);
+          if (!narrow(c, dom[c]&hasSide[d]) || !narrow(x, dom[x]&hasSide[net->opposite(d)])) return false;
+          forced=true;
+        }
+      }
+      bool settled = !changed && !forced && net->shape==Torus;   //edges do this job elsewhere, faster
+      for(int c=0;c<n && settled;c++)   //two last ends
+        for(int d=1;d<=net->dirs/2;d++)
+        {
+          int x=net->next(c,d), g=sets.find(c), h=sets.find(x);
+          if (open(c,d) || shut(c,d) || g==h) continue;
+          if (ends[g]==1 && ends[h]==1 && groupSize[g]+groupSize[h]<n)
+          {
+            if (!narrow(c, dom[c]&~hasSide[d]) || !narrow(x, dom[x]&~hasSide[net->opposite(d)])) return false;
+            forced=true;
+          }
+        }
+      changed = changed || forced;
+      if (!changed) return true;
+      if (!propagate()) return false;
+    }
+  }
+
+  void search()
+  {
+    nodes++;
+    if (!propagate() || !groups()) return;
+
+    int best=-1, bestCount=65;
+    for(int c=0;c<n && bestCount>2;c++)
+    {
+      int k=0;
+      for(uint64_t D=dom[c];D;D&=D-1) k++;
+      if (k>1 && k<bestCount) {best=c; bestCount=k;}
+    }
+
+    if (best<0)   //every pipe fixed, one tree
+    {
+      if (!found++)
+        for(int c=0;c<n;c++) {int m=0; while(!(dom[c]>>m&1)) m++; solution.cells[c]=m;}
+      return;
+    }
+
+    size_t mark=trail.size();
+    for(uint64_t D=dom[best];D && found<limit;D&=D-1)
+    {
+      undo(mark);
+      narrow(best, D&(~D+1));
+      search();
+    }
+  }
+
+  void start(const Net &puzzle, int lim)
+  {
+    net=&puzzle; n=puzzle.size(); limit=lim;
+    found=0; nodes=0;
+    solution=puzzle;
+    dom.assign(n+1,0); queued.assign(n+1,0); queue.clear(); trail.clear();
+    dom[n]=1;   //off the board: no pipes, nothing else
+    pipeCount.resize(n);
+    for(int c=0;c<n;c++)
+    {
+      int m=puzzle.cells[c];
+      pipeCount[c]=pipes(m);
+      for(int k=0;k<puzzle.dirs;k++) {dom[c] |= 1ull<<m; m=puzzle.turn(m);}
+      push(c);
+    }
+  }
+
+  // puzzle: any rotation of every pipe; solution gets the first answer found
+  int count(const Net &puzzle, int lim=2)
+  {
+    start(puzzle, lim);
+    search();
+    return found;
+  }
+
+  // deduction only, no guessing: true when it pins down every pipe, which
+  // also proves the answer is the only one. Cells left open are in dom.
+  bool deduce(const Net &puzzle)
+  {
+    start(puzzle, 1);
+    if (!propagate() || !groups()) return false;
+    for(int c=0;c<n;c++) if (dom[c]&(dom[c]-1)) return false;
+    return true;
+  }
+};
+
+// Reworks a generated tree until deduce() solves its puzzle, which makes
+// the answer unique: where deduction gets stuck a link is moved, a few
+// places at once on big boards. False if `rounds` weren't enough.
+inline bool makeUnique(Net &tree, uint32_t &seed, Solver &solver, int rounds)
+{
+  std::vector<int> side(tree.size()+1,0), open;
+  int stamp=0;
+  for(int r=0;r<rounds;r++)
+  {
+    if (solver.deduce(tree)) return true;
+    open.clear();
+    for(int c=0;c<tree.size();c++) if (solver.dom[c]&(solver.dom[c]-1)) open.push_back(c);
+    if (open.empty()) return false;
+    for(int k=0;k<=int(open.size())/8;k++) perturb(tree, open[xorshift(seed)%open.size()], seed, side, stamp);
+  }
+  return false;
+}
+
+#endif
@@ -0,0 +1,72 @@
+// Puzzle batches with a certified unique answer, e.g. for daily challenges:
+//   g++ -std=c++11 -O2 -pthread gen.cpp -o gen
+//   ./gen [count=1000] [size=100] [seed=1] [out=puzzles.txt] [threads=all] [square|torus|hex]
+// Every line of the output is "shape width height puzzle answer", the last
+// two one pipe mask per cell, row by row, as a hex digit (two on hex
+// boards). A puzzle is kept when
+// the solver counts exactly one answer and it is the generated one.
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include "Puzzle.hpp"
+#include "../common/Jobs.hpp"
+
+std::string hex(const Net &net)
+{
+  std::string s;
+  for(int c=0;c<net.size();c++)
+  {
+    if (net.dirs>4) s+="0123456789abcdef"[net.cells[c]>>4];
+    s+="0123456789abcdef"[net.cells[c]&15];
+  }
+  return s;
+}
+
+int main(int argc, char *argv[])
+{
+  int count   = argc>1 ? atoi(argv[1]) : 1000;
+  int size    = argc>2 ? atoi(argv[2]) : 100;
+  int seed    = argc>3 ? atoi(argv[3]) : 1;
+  const char *file = argc>4 ? argv[4] : "puzzles.txt";
+  int threads = argc>5 ? atoi(argv[5]) : std::thread::hardware_concurrency();
+  std::string name = argc>6 ? argv[6] : "square";
+  Shape shape = name=="torus" ? Torus : name=="hex" ? Hex : Square;
+
+  std::vector<std::string> lines(count);
+  std::vector<int> tries(count, 0);
+  Jobs jobs(threads);
+
+  auto t0 = std::chrono::steady_clock::now();
+  jobs.run(count, 1, [&](int a,int b)
+   {
+     Solver solver;
+     for(int i=a;i<b;i++)
+      for(uint32_t s=(seed*2654435761u)^(i*40503u);;s+=0x9e3779b9u)  //next seed if a board doesn't work out
+      {
+        tries[i]++;
+        Net tree(size,size,shape), puzzle;
+        uint32_t r=s|1;
+        generate(tree, r);
+        if (!makeUnique(tree, r, solver, 1000)) continue;
+        puzzle = tree;
+        scramble(puzzle, r);
+        if (solver.count(puzzle,2)!=1 || solver.solution.cells!=tree.cells) continue;
+        lines[i] = name+" "+std::to_string(size)+" "+std::to_string(size)+" "+hex(puzzle)+" "+hex(tree);
+        break;
+      }
+   });
+  double t = std::chrono::duration<double>(std::chrono::steady_clock::now()-t0).count();
+
+  FILE *out = fopen(file, "w");
+  if (!out) {printf("can't write %s\n", file); return 1;}
+  for(auto &l: lines) fprintf(out, "%s\n", l.c_str());
+  fclose(out);
+
+  long long boards=0;
+  for(int n: tries) boards+=n;
+  printf("%d unique %dx%d %s puzzles in %.2fs on %d threads: %.0f per minute\n", count, size, size, name.c_str(), t, threads, count/t*60);
+  printf("%.2f boards generated per puzzle kept\n", double(boards)/count);
+  return 0;
+}
@@ -1,92 +1,29 @@
 #include <SFML/Graphics.hpp>
 #include <time.h>
+#include "Puzzle.hpp"
 using namespace sf;
 
 const int N = 6;
 int ts = 54; //tile size
 Vector2f offset(65,55);
 
-Vector2i Up(0,-1);
-Vector2i Down(0,1);
-Vector2i Right(1,0);
-Vector2i Left(-1,0);
+Net net(N,N); //pipe masks, "torus" on the command line wraps the edges
 
-Vector2i DIR[4] = {Up,Right,Down,Left};
-
-struct pipe
+struct pipe   //how a cell is shown
 {
-  std::vector<Vector2i> dirs;
   int orientation;
-  float angle; bool on;
+  float angle;
 
   pipe() {angle=0;}
+} grid[N*N];
 
-  void rotate()
-  {
-    for(int i=0;i<dirs.size();i++)
-      if (dirs[i]==Up)  dirs[i]=Right;
-      else if (dirs[i]==Right) dirs[i]=Down;
-      else if (dirs[i]==Down)  dirs[i]=Left;
-      else if (dirs[i]==Left)  dirs[i]=Up;
-  }
-
-  bool isConnect(Vector2i dir)
-  {
-    for(auto d: dirs)
-     if (d==dir) return true;
-    return false;
-  }
-};
-
-
-pipe grid[N][N];
-pipe& cell(Vector2i v) {return grid[v.x][v.y];}
-bool isOut(Vector2i v) {return !IntRect(0,0,N,N).contains(v);}
-
-
-void generatePuzzle()
-{
-  std::vector<Vector2i> nodes;
-  nodes.push_back(Vector2i(rand()%N,rand()%N));
-
-  while(!nodes.empty())
-  {
-    int n = rand()%nodes.size();
-    Vector2i v = nodes[n];
-    Vector2i d = DIR[rand()%4];
-
-    if (cell(v).dirs.size()==3) {nodes.erase(nodes.begin() + n); continue;}
-    if (cell(v).dirs.size()==2) if (rand()%50) continue;
-
-    bool complete=1;
-    for(auto D:DIR)
-     if (!isOut(v+D) && cell(v+D).dirs.empty()) complete=0;
-    if (complete) {nodes.erase(nodes.begin() + n); continue; }
-
-    if (isOut(v+d)) continue;
-    if (!cell(v+d).dirs.empty()) continue;
-    cell(v).dirs.push_back(d);
-    cell(v+d).dirs.push_back(-d);
-    nodes.push_back(v+d);
-  }
-}
-
+int degree(int c) {return pipes(net.cells[c]);}
 
-void drop(Vector2i v)
-{
-   if (cell(v).on) return;
-   cell(v).on=true;
-
-   for(auto d:DIR)
-    if (!isOut(v+d))
-     if (cell(v).isConnect(d) && cell(v+d).isConnect(-d))
-       drop(v+d);
-}
 
-
-int main()
+int main(int argc, char *argv[])
 {
     srand(time(0));
+    if (argc>1 && std::string(argv[1])=="torus") net = Net(N,N,Torus);
 
     RenderWindow app(VideoMode(390, 390), "The Pipe Puzzle!");
 
@@ -103,30 +40,27 @@ int main()
     sServer.setOrigin(20,20);
 
 
-    generatePuzzle();
+    uint32_t seed = rand();
+    Solver solver;
+    generate(net, seed);
+    makeUnique(net, seed, solver, 100); //only one way to solve it
 
-    for(int i=0;i<N;i++)
-     for(int j=0;j<N;j++)
+    for(int c=0;c<N*N;c++)
        {
-         pipe &p = grid[j][i];
-
-         for(int n=4;n>0;n--) //find orientation//
-         {
-          std::string s="";
-          for(auto d: DIR) s+=p.isConnect(d)? '1':'0';
-          if (s=="0011" || s=="0111" || s=="0101" || s=="0010") p.orientation=n;
-          p.rotate();
-         }
+         grid[c].orientation = orientationOf(net.cells[c]);
 
          for(int n=0;n<rand()%4;n++) //shuffle//
-          {grid[j][i].orientation++; grid[j][i].rotate();}
+          {grid[c].orientation++; net.rotate(c);}
        }
 
-    Vector2i servPos;
-    while(cell(servPos).dirs.size()==1) {servPos = Vector2i(rand()%N, rand()%N);}
-    sServer.setPosition(Vector2f(servPos*ts));
+    int serv=0;
+    while(degree(serv)==1) serv = rand()%(N*N);
+    sServer.setPosition(serv%N*ts, serv/N*ts);
     sServer.move(offset);
 
+    Power power(net, serv);
+    power.update();
+
     while (app.isOpen())
     {
         Event e;
@@ -140,15 +74,12 @@ int main()
                   {
                     Vector2i pos = Mouse::getPosition(app) + Vector2i(ts/2,ts/2) - Vector2i(offset);
                     pos/=ts;
-                    if (isOut(pos)) continue;
-                    cell(pos).orientation++;
-                    cell(pos).rotate();
-
-                    for(int i=0;i<N;i++)
-                     for(int j=0;j<N;j++)
-                      grid[j][i].on=0;
-
-                    drop(servPos);
+                    if (net.isOut(pos.x,pos.y)) continue;
+                    int c = net.index(pos.x,pos.y);
+                    grid[c].orientation++;
+                    net.rotate(c);
+                    power.rotated(c);
+                    app.setTitle(power.solved() ? "The Pipe Puzzle! Solved!" : "The Pipe Puzzle!");
                   }
         }
 
@@ -158,10 +89,8 @@ int main()
         for(int i=0;i<N;i++)
          for(int j=0;j<N;j++)
            {
-            pipe &p = grid[j][i];
-
-            int kind = p.dirs.size();
-            if (kind==2 && p.dirs[0]==-p.dirs[1]) kind=0;
+            pipe &p = grid[i*N+j];
+            int kind = kindOf(net.cells[i*N+j]);
 
             p.angle+=5;
             if (p.angle>p.orientation*90) p.angle=p.orientation*90;
@@ -172,7 +101,7 @@ int main()
             app.draw(sPipe);
 
             if (kind==1)
-               { if (p.on) sComp.setTextureRect(IntRect(53,0,36,36));
+               { if (power.isOn(i*N+j)) sComp.setTextureRect(IntRect(53,0,36,36));
                  else sComp.setTextureRect(IntRect(0,0,36,36));
                  sComp.setPosition(j*ts,i*ts);sComp.move(offset);
                  app.draw(sComp);
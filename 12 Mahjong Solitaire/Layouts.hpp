@@ -0,0 +1,176 @@
+#ifndef LAYOUTS_H
+#define LAYOUTS_H
+
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include "Tiles.hpp"
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// A layout pack, files/layouts.bin, made by layouts.cpp. Everything is
+// little endian and 4-byte aligned, so the file is used in place:
+//
+//   PackHeader
+//   PackEntry[count]                 one per layout
+//   per layout, at its offset:
+//     PackTile[tiles]                in drawing order
+//     uint32_t first[tiles*4+1]      Tiles::first
+//     uint16_t links[links]          Tiles::links, padded to 4 bytes
+//
+// The checksum is FNV-1a over every byte after the header.
+const char packMagic[4] = {'M','J','L','P'};
+const uint32_t packVersion = 1;
+
+struct PackHeader {char magic[4]; uint32_t version, count, bytes, checksum;};
+struct PackEntry {char name[24]; uint32_t offset, tiles, links;};
+struct PackTile {int16_t x, y, z, pad;};
+
+inline uint32_t fnv(const unsigned char *p, size_t n)
+{
+  uint32_t h=2166136261u;
+  for(size_t i=0;i<n;i++) {h^=p[i]; h*=16777619u;}
+  return h;
+}
+
+inline size_t packBlock(uint32_t tiles, uint32_t links)   //bytes of one layout, padded
+{
+  return (size_t(tiles)*sizeof(PackTile) + (size_t(tiles)*4+1)*4 + size_t(links)*2 + 3) & ~size_t(3);
+}
+
+// Maps the pack into memory (reads it in where there's no mmap) and checks
+// it once: header, checksum, and that every index stays inside its layout.
+// get() then only copies arrays, no parsing.
+struct Pack
+{
+  const unsigned char *data;
+  size_t size;
+  std::vector<unsigned char> copy;
+  void *mapped;
+
+  Pack() : data(0), size(0), mapped(0) {}
+  ~Pack() {close();}
+
+  void close()
+  {
+#ifndef _WIN32
+    if (mapped) munmap(mapped, size);
+#endif
+    mapped=0; data=0; size=0; copy.clear();
+  }
+
+  bool open(const char *file)
+  {
+    close();
+#ifndef _WIN32
+    int fd=::open(file, O_RDONLY);
+    if (fd<0) return false;
+    struct stat st;
+    if (fstat(fd,&st)==0 && st.st_size>0)
+    {
+      void *p=mmap(0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (p!=MAP_FAILED) {mapped=p; data=(const unsigned char*)p; size=st.st_size;}
+    }
+    ::close(fd);
+#endif
+    if (!data)   //no mmap here: read it in
+    {
+      FILE *f=fopen(file, "rb");
+      if (!f) return false;
+      fseek(f, 0, SEEK_END); long n=ftell(f); fseek(f, 0, SEEK_SET);
+      if (n>0) copy.resize(n);
+      if (n<=0 || fread(&copy[0], 1, n, f)!=size_t(n)) copy.clear();
+      fclose(f);
+      data=copy.empty() ? 0 : &copy[0]; size=copy.size();
+    }
+    if (!valid()) {close(); return false;}
+    return true;
+  }
+
+  const PackHeader &header() const {return *(const PackHeader*)data;}
+  const PackEntry &entry(int i) const {return ((const PackEntry*)(data+sizeof(PackHeader)))[i];}
+  int count() const {return data ? header().count : 0;}
+  const char *name(int i) const {return entry(i).name;}
+
+  bool valid() const
+  {
+    if (!data || size<sizeof(PackHeader)) return false;
+    const PackHeader &h=header();
+    if (memcmp(h.magic, packMagic, 4) || h.version!=packVersion || h.bytes!=size) return false;
+    if (h.count > (size-sizeof(PackHeader))/sizeof(PackEntry)) return false;
+    if (fnv(data+sizeof(PackHeader), size-sizeof(PackHeader))!=h.checksum) return false;
+
+    for(uint32_t i=0;i<h.count;i++)
+    {
+      const PackEntry &e=entry(i);
+      if (e.offset%4 || e.tiles>65535 || e.offset>size || packBlock(e.tiles,e.links)>size-e.offset) return false;
+      if (!memchr(e.name, 0, sizeof(e.name))) return false;
+      const uint32_t *first=(const uint32_t*)(data+e.offset+e.tiles*sizeof(PackTile));
+      const uint16_t *links=(const uint16_t*)(first+e.tiles*4+1);
+      if (first[0]!=0 || first[e.tiles*4]!=e.links) return false;
+      for(uint32_t k=0;k<e.tiles*4;k++) if (first[k]>first[k+1]) return false;
+      for(uint32_t k=0;k<e.links;k++) if (links[k]>=e.tiles) return false;
+    }
+    return true;
+  }
+
+  // layout i into `board`, every tile on the table and not dealt yet
+  void get(int i, Tiles &board) const
+  {
+    const PackEntry &e=entry(i);
+    const PackTile *t=(const PackTile*)(data+e.offset);
+    const uint32_t *first=(const uint32_t*)(t+e.tiles);
+    const uint16_t *links=(const uint16_t*)(first+e.tiles*4+1);
+
+    board.tiles.resize(e.tiles);
+    for(uint32_t k=0;k<e.tiles;k++) {Tile tl={t[k].x, t[k].y, t[k].z, 0}; board.tiles[k]=tl;}
+    board.first.assign(first, first+e.tiles*4+1);
+    board.links.assign(links, links+e.links);
+    board.reset();
+  }
+};
+
+// writes a pack of already built layouts; layouts.cpp uses it
+inline bool writePack(const char *file, const std::vector<std::string> &names, const std::vector<Tiles> &layouts)
+{
+  std::vector<unsigned char> out(sizeof(PackHeader) + layouts.size()*sizeof(PackEntry));
+  for(size_t i=0;i<layouts.size();i++)
+  {
+    const Tiles &l=layouts[i];
+    PackEntry e;
+    memset(&e, 0, sizeof(e));
+    strncpy(e.name, names[i].c_str(), sizeof(e.name)-1);
+    e.offset=out.size(); e.tiles=l.size(); e.links=l.links.size();
+    memcpy(&out[sizeof(PackHeader)+i*sizeof(PackEntry)], &e, sizeof(e));
+
+    out.resize(out.size()+packBlock(e.tiles,e.links), 0);
+    unsigned char *p=&out[e.offset];
+    for(const Tile &t: l.tiles)
+    {
+      PackTile pt={int16_t(t.x), int16_t(t.y), int16_t(t.z), 0};
+      memcpy(p, &pt, sizeof(pt)); p+=sizeof(pt);
+    }
+    for(int f: l.first) {uint32_t v=f; memcpy(p, &v, 4); p+=4;}
+    for(int k: l.links) {uint16_t v=k; memcpy(p, &v, 2); p+=2;}
+  }
+
+  PackHeader h;
+  memcpy(h.magic, packMagic, 4);
+  h.version=packVersion; h.count=layouts.size(); h.bytes=out.size();
+  h.checksum=fnv(&out[sizeof(PackHeader)], out.size()-sizeof(PackHeader));
+  memcpy(&out[0], &h, sizeof(h));
+
+  FILE *f=fopen(file, "wb");
+  if (!f) return false;
+  bool ok = fwrite(&out[0], 1, out.size(), f)==out.size();
+  return fclose(f)==0 && ok;
+}
+
+#endif
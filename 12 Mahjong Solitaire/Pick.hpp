@@ -0,0 +1,84 @@
+#ifndef PICK_H
+#define PICK_H
+
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include "Tiles.hpp"
+
+// Which tile is under the mouse. The screen is cut into buckets the size
+// of half a tile; each bucket lists the tiles whose click area overlaps
+// it, topmost first (the reverse of the drawing order). A click looks at
+// one bucket and takes the first open tile there that holds the point, so
+// it costs the height of one stack, not the size of the board.
+//
+// Tiles stay listed after they are removed, isOpen() skips them, so the
+// index is only built again for a new layout.
+struct Picker
+{
+  float stepX, stepY, offX, offY, deskX, deskY;   //same numbers the tiles are drawn with
+  float x0, y0;                                   //screen corner of bucket (0,0)
+  int cols, rows;
+  std::vector<int> first, items;                  //items[first[b] .. first[b+1]): tiles of bucket b
+
+  Picker(float sx=22, float sy=31, float ox=4.6, float oy=7.1, float dx=30, float dy=0)
+    : stepX(sx), stepY(sy), offX(ox), offY(oy), deskX(dx), deskY(dy), x0(0), y0(0), cols(0), rows(0) {}
+
+  // click area of tile t: the two by two cells it stands on
+  float left(const Tile &a) const {return a.x*stepX + a.z*offX + deskX;}
+  float top(const Tile &a) const {return a.y*stepY - a.z*offY + deskY;}
+
+  void build(const Tiles &b)
+  {
+    int n=b.size();
+    cols=rows=0; first.assign(1,0); items.clear();
+    if (!n) return;
+
+    x0=y0=1e9; float x1=-1e9, y1=-1e9;
+    for(auto &a: b.tiles)
+    {
+      x0=std::min(x0,left(a)); y0=std::min(y0,top(a));
+      x1=std::max(x1,left(a)+2*stepX); y1=std::max(y1,top(a)+2*stepY);
+    }
+    cols=int((x1-x0)/stepX)+1; rows=int((y1-y0)/stepY)+1;
+
+    // counting pass, then fill: two walks over the tiles, no lists per bucket
+    first.assign(cols*rows+1, 0);
+    for(int pass=0;pass<2;pass++)
+    {
+      std::vector<int> at(first.begin(), first.end()-1);
+      for(int t=n-1;t>=0;t--)
+      {
+        const Tile &a=b.tiles[t];
+        int c0=int((left(a)-x0)/stepX), c1=int((left(a)+2*stepX-x0)/stepX);
+        int r0=int((top(a)-y0)/stepY), r1=int((top(a)+2*stepY-y0)/stepY);
+        for(int r=r0;r<=std::min(r1,rows-1);r++)
+         for(int c=c0;c<=std::min(c1,cols-1);c++)
+          if (pass==0) first[r*cols+c+1]++;
+          else items[at[r*cols+c]++]=t;
+      }
+      if (pass==0)
+      {
+        for(int i=0;i<cols*rows;i++) first[i+1]+=first[i];
+        items.resize(first[cols*rows]);
+      }
+    }
+  }
+
+  // topmost open tile holding screen point (px,py), -1 if none
+  int pick(const Tiles &b, float px, float py) const
+  {
+    int c=int(std::floor((px-x0)/stepX)), r=int(std::floor((py-y0)/stepY));
+    if (c<0 || r<0 || c>=cols || r>=rows) return -1;
+    for(int i=first[r*cols+c];i<first[r*cols+c+1];i++)
+    {
+      int t=items[i];
+      const Tile &a=b.tiles[t];
+      float x=px-left(a), y=py-top(a);
+      if (x>=0 && x<2*stepX && y>=0 && y<2*stepY && b.isOpen(t)) return t;
+    }
+    return -1;
+  }
+};
+
+#endif
@@ -0,0 +1,389 @@
+#ifndef SOLVER_H
+#define SOLVER_H
+
+#include <vector>
+#include <unordered_set>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <cstdint>
+#include <algorithm>
+#include "Tiles.hpp"
+#include "../common/Jobs.hpp"
+#include "../common/Random.hpp"
+
+// Deals the kinds the way the game always has: two random open tiles get
+// the next kind and come off, until the layout is empty. Putting the pairs
+// back in reverse order solves it, so every deal has a way out. False when
+// it ran out of open tiles first; the tiles left over stay off the table.
+inline bool deal(Tiles &b, uint32_t &seed)
+{
+  if (!seed) seed=1;
+  for(auto &t: b.tiles) t.kind=0;
+  b.reset();
+  for(int k=1;;k++)
+  {
+    int n=b.opens.size();
+    if (n<2) break;
+    int i=0,j=0;
+    while(i==j){i=xorshift(seed)%n; j=xorshift(seed)%n;}
+    int x=b.opens[i], y=b.opens[j];
+    b.remove(x); b.remove(y);   //before they get a kind, so the counts skip them
+    b.tiles[x].kind=k;  if (k>34) k++;
+    b.tiles[y].kind=k;
+    k%=42;
+  }
+
+  b.reset();
+  bool all=true;
+  for(int t=0;t<b.size();t++)
+    if (!b.tiles[t].kind) {b.remove(t); all=false;}
+  return all;
+}
+
+struct Pair {int a, b;};
+
+// Depth first search for a way to clear the table.
+//
+// A position is the set of tiles still on the table, hashed Zobrist style
+// (xor of a random key per tile), so positions reached in another order
+// are only searched once: the ones without a way out go into `dead`.
+// When every live tile of a group is open two of them are taken without
+// trying anything else, since nothing can block them any more. Otherwise
+// tiles in the way of their own kind go first. Greedy rules like "free
+// the most tiles" lead it astray on some deals for very long, so instead
+// the search restarts with a doubled budget and ties broken at random,
+// keeping what it learned in `dead`.
+struct Solver
+{
+  Tiles b;
+  std::vector<uint64_t> key;
+  uint64_t hash;
+  std::unordered_set<uint64_t> dead;
+  const std::unordered_set<uint64_t> *known;  //parallel search: dead positions every thread found so far
+  std::vector<int> liveOf;               //live tiles of each group
+  std::vector<std::vector<int> > tilesOf; //all tiles of each group
+  std::vector<int> seen;
+  int stamp;
+  std::vector<std::vector<Pair> > stack;  //moves of every depth
+  std::vector<int> order, own;            //open tiles by group, blocksOwn() of each
+  std::vector<uint64_t> score;            //per move: its score above its place in the list
+  std::vector<Pair> sorted;
+  std::vector<Pair> path;                 //the way out, first move first
+  std::vector<Pair> roots;                //parallel search: the first moves this one may make, any when empty
+  int left;
+  long long nodes, limit;
+  bool gaveUp;
+  const std::atomic<bool> *found;         //parallel search: another root move has the answer
+  const std::atomic<bool> *halt;          //stop as soon as this is set, the answer is not wanted
+  uint32_t shuffle;                       //breaks ties between moves at random when not 0
+
+  Solver() : hash(0), known(0), stamp(0), left(0), nodes(0), limit(0), gaveUp(false), found(0), halt(0), shuffle(0) {}
+
+  bool stopped() const {return (found && *found) || (halt && *halt);}
+
+  // dead positions stay dead, so `dead` is kept from one start to the next;
+  // run() clears it
+  void start(const Tiles &board, long long lim)
+  {
+    b=board; nodes=0; limit=lim; gaveUp=false; path.clear();
+    if (int(key.size())!=b.size())
+    {
+      key.resize(b.size());
+      for(int t=0;t<b.size();t++) key[t]=splitmix(t+1);
+    }
+    hash=0; left=0; liveOf.assign(43,0);
+    tilesOf.assign(43, std::vector<int>());
+    seen.assign(b.size(),0);
+    for(int t=0;t<b.size();t++)
+    {
+      tilesOf[group(b.tiles[t].kind)].push_back(t);
+      if (b.live[t]) {hash^=key[t]; left++; liveOf[group(b.tiles[t].kind)]++;}
+    }
+    stack.resize(left/2+1);
+  }
+
+  void take(Pair m)
+  {
+    b.remove(m.a); b.remove(m.b);
+    hash^=key[m.a]^key[m.b]; left-=2;
+    liveOf[group(b.tiles[m.a].kind)]-=2;
+  }
+
+  void undo(Pair m)
+  {
+    b.restore(m.b); b.restore(m.a);
+    hash^=key[m.a]^key[m.b]; left+=2;
+    liveOf[group(b.tiles[m.a].kind)]+=2;
+  }
+
+  // true when tile `top` lies on `t`, straight or through other live tiles
+  bool over(int top,int t)
+  {
+    if (top==t) return true;
+    if (seen[top]==stamp) return false;
+    seen[top]=stamp;
+    for(const int *p=b.begin(top,Below);p!=b.end(top,Below);p++)
+      if (b.live[*p] && over(*p,t)) return true;
+    return false;
+  }
+
+  // the last two tiles of a group, one under the other, can never meet
+  bool locked(int g)
+  {
+    if (liveOf[g]!=2) return false;
+    int x=-1, y=-1;
+    for(int t: tilesOf[g]) if (b.live[t]) (x<0 ? x : y)=t;
+    stamp++;
+    if (b.tiles[x].z<b.tiles[y].z) std::swap(x,y);
+    return over(x,y);
+  }
+
+  // live tiles of its own group that t lies on or next to: those can't
+  // pair with it, so it is better gone first
+  int blocksOwn(int t) const
+  {
+    int n=0, g=group(b.tiles[t].kind);
+    for(int s: {Below, LeftOf, RightOf})
+      for(const int *p=b.begin(t,s);p!=b.end(t,s);p++) n += b.live[*p] && group(b.tiles[*p].kind)==g;
+    return n;
+  }
+
+  void moves(std::vector<Pair> &out)
+  {
+    out.clear();
+    order.assign(b.opens.begin(), b.opens.end());
+    std::sort(order.begin(), order.end(), [&](int x,int y)
+      {int gx=group(b.tiles[x].kind), gy=group(b.tiles[y].kind); return gx!=gy ? gx<gy : x<y;});
+
+    score.clear(); own.resize(order.size());
+    for(size_t i=0;i<order.size();i++) own[i]=blocksOwn(order[i]);
+    for(size_t i=0,j;i<order.size();i=j)
+    {
+      int g=group(b.tiles[order[i]].kind);
+      for(j=i;j<order.size() && group(b.tiles[order[j]].kind)==g;j++);
+      if (j-i<2) continue;
+      if (int(j-i)==liveOf[g]) {Pair m={order[i],order[i+1]}; out.assign(1,m); return;}   //safe
+      for(size_t x=i;x<j;x++)
+       for(size_t y=x+1;y<j;y++)
+        {
+          Pair m={order[x],order[y]};
+          uint64_t sc = (own[x]+own[y])*16 + (shuffle ? xorshift(shuffle)%16 : 0);
+          score.push_back(~sc<<32 | out.size());   //highest first, ties in list order
+          out.push_back(m);
+        }
+    }
+
+    std::sort(score.begin(), score.end());
+    sorted.resize(out.size());
+    for(size_t i=0;i<out.size();i++) sorted[i]=out[uint32_t(score[i])];
+    out.swap(sorted);
+  }
+
+  bool solve(int depth)
+  {
+    if (!left) return true;
+    if (++nodes>limit || stopped()) {gaveUp=true; return false;}
+    if (dead.count(hash) || (known && known->count(hash))) return false;
+
+    std::vector<Pair> &ms=stack[depth];
+    moves(ms);
+    if (!depth && !roots.empty())
+      ms.erase(std::remove_if(ms.begin(), ms.end(), [&](Pair m)
+        {for(Pair r: roots) if (r.a==m.a && r.b==m.b) return false; return true;}), ms.end());
+    for(size_t i=0;i<ms.size();i++)
+    {
+      Pair m=ms[i];
+      take(m); path.push_back(m);
+      if (!locked(group(b.tiles[m.a].kind)) && solve(depth+1)) return true;
+      path.pop_back(); undo(m);
+      if (gaveUp) return false;
+    }
+    dead.insert(hash);
+    return false;
+  }
+
+  // 1 solvable (the moves are in `path`), 0 no way out, -1 gave up after
+  // looking at `lim` positions
+  int run(const Tiles &board, long long lim=1000000)
+  {
+    dead.clear(); shuffle=0;
+    long long used=0;
+    for(long long step=100;;step*=2)
+    {
+      start(board, std::min(step, lim-used));
+      bool ok=solve(0);
+      used+=nodes;
+      if (ok || !gaveUp || used>=lim || stopped())
+      {
+        nodes=used;
+        return ok ? 1 : gaveUp ? -1 : 0;
+      }
+      shuffle=uint32_t(splitmix(step*1000))|1;
+    }
+  }
+};
+
+// The same search over a pool of threads. Moves with no choice are taken
+// first, then the moves of the first real choice are dealt out over the
+// threads, and each searches from its share of them in rounds like run().
+// Between rounds the dead positions every thread found go into one table
+// they all read, so nothing ruled out once is searched again, and `limit`
+// is shared out between them. The first way out found is the answer and
+// stops the rest.
+inline int solve(Jobs &jobs, const Tiles &board, std::vector<Pair> &path, long long limit=1000000, long long *nodes=0,
+                 const std::atomic<bool> *halt=0)
+{
+  Solver root;
+  root.start(board, limit);
+  path.clear();
+  std::vector<Pair> ms;
+  for(root.moves(ms); root.left && ms.size()==1; root.moves(ms)) {root.take(ms[0]); path.push_back(ms[0]);}
+  if (nodes) *nodes=path.size();
+  if (!root.left) return 1;
+  if (ms.empty()) return 0;
+
+  int n=std::min<int>(ms.size(), jobs.size());
+  std::vector<Solver> s(n);
+  std::vector<char> settled(n, 0);      //no way out from its share
+  std::unordered_set<uint64_t> known;
+  std::vector<Pair> way;
+  std::mutex m;
+  std::atomic<bool> found(false);
+  long long used=0;
+  for(size_t i=0;i<ms.size();i++) s[i%n].roots.push_back(ms[i]);
+  for(int i=0;i<n;i++) {s[i].known=&known; s[i].found=&found; s[i].halt=halt;}
+
+  for(long long step=100;;step*=2)
+  {
+    int open=std::count(settled.begin(), settled.end(), 0);
+    long long each=std::max(1LL, std::min(step, (limit-used)/open));
+    jobs.run(n, 1, [&](int a,int e)
+     {
+       for(int i=a;i<e;i++)
+       {
+         if (settled[i] || found) continue;
+         s[i].start(root.b, each);
+         if (s[i].solve(0))
+         {
+           std::lock_guard<std::mutex> lock(m);
+           if (!found) {way=s[i].path; found=true;}
+         }
+         else if (!s[i].gaveUp) settled[i]=1;
+       }
+     });
+    for(int i=0;i<n;i++)
+    {
+      used+=s[i].nodes; s[i].nodes=0;
+      known.insert(s[i].dead.begin(), s[i].dead.end());
+      s[i].dead.clear();
+      s[i].shuffle=uint32_t(splitmix(step*1000+i))|1;
+    }
+
+    open=std::count(settled.begin(), settled.end(), 0);
+    if (found || !open || used>=limit || (halt && *halt))
+    {
+      if (nodes) *nodes+=used;
+      if (found) path.insert(path.end(), way.begin(), way.end());
+      return found ? 1 : open ? -1 : 0;
+    }
+  }
+}
+
+// Deals and hints for the game window, worked out off its thread so it
+// keeps drawing: newDeal() and findHint() start one on a thread of their
+// own and return at once, the frame loop calls poll() until it is done.
+// Asking again, or cancel(), stops the one running and forgets it.
+// Deals are tried one per pool thread at a time; the first that clears in
+// seed order is taken, so a seed gives the same deal on any machine.
+struct Helper
+{
+  enum Task {Idle, Dealing, Hinting};
+
+  Jobs &jobs;
+  std::thread runner;
+  std::mutex m;
+  std::atomic<bool> halt;
+  Task task;       //the one running, or done and not collected yet
+  bool done;
+  Tiles board;     //the deal
+  uint32_t seed;   //where the next deal starts
+  Pair move;       //the hint, -1 if none
+  int result;      //of the hint, as solve()
+
+  Helper(Jobs &j) : jobs(j), halt(false), task(Idle), done(false), seed(1), result(0) {move.a=move.b=-1;}
+  ~Helper() {cancel();}
+
+  void cancel()
+  {
+    halt=true;
+    if (runner.joinable()) runner.join();
+    halt=false; task=Idle; done=false;
+  }
+
+  // the first deal from seed `from` on that the solver clears
+  void newDeal(const Tiles &layout, uint32_t from)
+  {
+    cancel();
+    task=Dealing; seed=from;
+    runner = std::thread([this, layout]
+    {
+      int n=jobs.size();
+      std::vector<Tiles> b(n, layout);
+      std::vector<char> ok(n);
+      for(uint32_t s=seed; !halt; s+=n)
+      {
+        jobs.run(n, 1, [&](int a,int e)
+         {
+           for(int i=a;i<e;i++)
+           {
+             Solver solver;
+             solver.halt=&halt;
+             uint32_t k=uint32_t(splitmix(s+i));
+             ok[i] = deal(b[i], k) && solver.run(b[i])==1;   //every tile dealt and the way out checked
+           }
+         });
+        for(int i=0;i<n;i++)
+          if (ok[i])
+          {
+            std::lock_guard<std::mutex> lock(m);
+            board=b[i]; seed=s+i+1; done=true;
+            return;
+          }
+      }
+    });
+  }
+
+  void findHint(const Tiles &now)
+  {
+    cancel();
+    task=Hinting;
+    runner = std::thread([this, now]
+    {
+      std::vector<Pair> path;
+      int r=solve(jobs, now, path, 1000000, 0, &halt);
+      std::lock_guard<std::mutex> lock(m);
+      result=r;
+      move = r==1 && !path.empty() ? path[0] : Pair{-1,-1};
+      done=true;
+    });
+  }
+
+  bool busy(Task t) {std::lock_guard<std::mutex> lock(m); return task==t && !done;}
+
+  // the task that has just finished, Idle if none: its answer is in
+  // board and seed, or in move and result
+  Task poll()
+  {
+    {
+      std::lock_guard<std::mutex> lock(m);
+      if (!done) return Idle;
+    }
+    runner.join();
+    Task t=task;
+    task=Idle; done=false;
+    return t;
+  }
+};
+
+#endif
@@ -0,0 +1,161 @@
+#ifndef TILES_H
+#define TILES_H
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <algorithm>
+
+// A tile covers 2x2 cells of the layout grid, (x,y) is its top left cell.
+// kind 1..42 picks the picture; 35..38 and 39..42 are the flowers and
+// seasons, which match anything of their own group.
+struct Tile {int x, y, z, kind;};
+
+inline bool match(int a,int b) {return a==b || (a>34 && a<39 && b>34 && b<39) || (a>=39 && b>=39);}
+inline int group(int kind) {return kind<35 ? kind : kind<39 ? 35 : 39;}   //kinds that match each other
+
+enum {LeftOf, RightOf, Above, Below};   //blocker lists of a tile
+
+// Every tile once, in the order they are drawn (by z, then right to left,
+// then top to bottom), with the tiles around it worked out at load time.
+// A tile is open when nothing lies on it and one of its sides is free;
+// each tile counts the live tiles on its left, right and top, so removing
+// or putting back a tile only touches its own neighbours. The open tiles
+// are counted per match group as well, which gives the number of moves
+// on the table at any time.
+struct Tiles
+{
+  std::vector<Tile> tiles;
+  std::vector<int> first, links;   //links[first[t*4+s] .. first[t*4+s+1]): list s of tile t
+  std::vector<char> live;
+  std::vector<int> left, right, above;   //live tiles blocking each side
+  std::vector<int> opens, openAt;        //open tiles in any order, their place there (-1 not open)
+  std::vector<int> openOf;               //open tiles of each group
+  int pairs;                             //moves available: matching pairs among the open tiles
+
+  int size() const {return tiles.size();}
+  const int *begin(int t,int s) const {return links.data()+first[t*4+s];}
+  const int *end(int t,int s) const {return links.data()+first[t*4+s+1];}
+
+  // the layout text: one digit per cell, the height of the stack there.
+  // A cell whose top left neighbour already holds a tile at that height is
+  // covered by it, so a run of 2x2 equal digits makes one tile per level.
+  bool load(const char *file)
+  {
+    std::ifstream in(file);
+    std::vector<std::string> rows;
+    for(std::string s; std::getline(in,s);)
+    {
+      if (!s.empty() && s[s.size()-1]=='\r') s.erase(s.size()-1);
+      if (!s.empty()) rows.push_back(s);
+    }
+    if (rows.empty()) return false;
+
+    int H=rows.size(), W=0, Z=0;
+    for(auto &r: rows) {W=std::max(W,int(r.size())); for(char c: r) Z=std::max(Z,c-'0');}
+    std::vector<char> taken((W+1)*(H+1)*(Z+1), 0);
+    auto at = [&](int x,int y,int z) -> char& {return taken[((y+1)*(W+1)+x+1)*(Z+1)+z];};
+
+    std::vector<Tile> t;
+    for(int y=0;y<H;y++)
+     for(int x=0;x<int(rows[y].size());x++)
+      for(int z=0;z<rows[y][x]-'0';z++)
+        if (at(x-1,y-1,z)) at(x-1,y,z)=at(x,y-1,z)=0;
+        else {at(x,y,z)=1; Tile tl={x,y,z,0}; t.push_back(tl);}
+
+    std::vector<Tile> kept;   //drop the cells cleared by a later tile
+    for(auto &tl: t) if (at(tl.x,tl.y,tl.z)) kept.push_back(tl);
+    build(kept);
+    return true;
+  }
+
+  // sorts into drawing order and finds every tile's blockers: tiles whose
+  // top left is two cells to the side and at most one cell up or down,
+  // and tiles one level up overlapping it
+  void build(std::vector<Tile> t)
+  {
+    std::sort(t.begin(), t.end(), [](const Tile &a,const Tile &b)
+      {return a.z!=b.z ? a.z<b.z : a.x!=b.x ? a.x>b.x : a.y<b.y;});
+    tiles = t;
+    int n=size(), W=0, H=0, Z=0;
+    for(auto &tl: tiles) {W=std::max(W,tl.x+1); H=std::max(H,tl.y+1); Z=std::max(Z,tl.z+1);}
+
+    std::vector<int> id((W+4)*(H+4)*(Z+1), -1);   //tile at each top left cell, with a margin
+    auto cell = [&](int x,int y,int z) {return ((y+2)*(W+4)+x+2)*(Z+1)+z;};
+    for(int i=0;i<n;i++) id[cell(tiles[i].x,tiles[i].y,tiles[i].z)]=i;
+
+    first.assign(n*4+1, 0); links.clear();
+    for(int i=0;i<n;i++)
+    {
+      const Tile &a=tiles[i];
+      for(int s=0;s<4;s++)
+      {
+        first[i*4+s]=links.size();
+        for(int dy=-1;dy<=1;dy++)
+         for(int k=-1;k<=1;k++)
+          {
+            int j=-1;
+            if (s==LeftOf && k==0)  j=id[cell(a.x-2,a.y+dy,a.z)];
+            if (s==RightOf && k==0) j=id[cell(a.x+2,a.y+dy,a.z)];
+            if (s==Above) j=id[cell(a.x+k,a.y+dy,a.z+1)];
+            if (s==Below && a.z>0) j=id[cell(a.x+k,a.y+dy,a.z-1)];
+            if (j>=0) links.push_back(j);
+          }
+      }
+    }
+    first[n*4]=links.size();
+    reset();
+  }
+
+  bool isOpen(int t) const {return live[t] && !above[t] && (!left[t] || !right[t]);}
+
+  // everything back on the table
+  void reset()
+  {
+    int n=size();
+    live.assign(n,1);
+    left.assign(n,0); right.assign(n,0); above.assign(n,0);
+    for(int t=0;t<n;t++)
+    {
+      left[t]=end(t,LeftOf)-begin(t,LeftOf);
+      right[t]=end(t,RightOf)-begin(t,RightOf);
+      above[t]=end(t,Above)-begin(t,Above);
+    }
+    opens.clear(); openAt.assign(n,-1);
+    openOf.assign(43,0); pairs=0;
+    for(int t=0;t<n;t++) check(t);
+  }
+
+  void remove(int t) {live[t]=0; changed(t,-1);}
+  void restore(int t) {live[t]=1; changed(t,+1);}
+
+  // keeps `opens` and the counts in step with one tile; tiles not dealt
+  // yet (kind 0) are left out of the counts
+  void check(int t)
+  {
+    bool o=isOpen(t);
+    int g=group(tiles[t].kind);
+    if (o && openAt[t]<0)
+    {
+      openAt[t]=opens.size(); opens.push_back(t);
+      if (g) pairs+=openOf[g]++;
+    }
+    if (!o && openAt[t]>=0)
+    {
+      int last=opens.back();
+      opens[openAt[t]]=last; openAt[last]=openAt[t];
+      opens.pop_back(); openAt[t]=-1;
+      if (g) pairs-=--openOf[g];
+    }
+  }
+
+  void changed(int t,int d)
+  {
+    for(const int *p=begin(t,LeftOf);p!=end(t,LeftOf);p++) {right[*p]+=d; check(*p);}
+    for(const int *p=begin(t,RightOf);p!=end(t,RightOf);p++) {left[*p]+=d; check(*p);}
+    for(const int *p=begin(t,Below);p!=end(t,Below);p++) {above[*p]+=d; check(*p);}
+    check(t);
+  }
+};
+
+#endif
@@ -0,0 +1,91 @@
+// Deal and solver timings on files/map.txt and bigger made-up layouts:
+//   g++ -std=c++11 -O2 -pthread bench.cpp -o bench
+//   ./bench [deals=200] [threads=all]
+// Every deal is solved from the start, once on one thread and once split
+// over the pool (the hint search). Kind labels are shuffled after the deal,
+// so the order kinds were handed out in gives the solver nothing away.
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include "Solver.hpp"
+
+double now() {return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();}
+
+// copies of a layout side by side and below each other
+std::vector<Tile> tiled(const Tiles &base, int nx, int ny)
+{
+  int W=0, H=0;
+  for(auto &t: base.tiles) {W=std::max(W,t.x+2); H=std::max(H,t.y+2);}
+  std::vector<Tile> out;
+  for(int i=0;i<nx;i++)
+   for(int j=0;j<ny;j++)
+    for(auto t: base.tiles) {t.x+=i*(W+1); t.y+=j*(H+1); out.push_back(t);}
+  return out;
+}
+
+// a w*h rectangle of tiles, every level one tile smaller on each side
+std::vector<Tile> pyramid(int w, int h)
+{
+  std::vector<Tile> out;
+  for(int z=0;2*z<w && 2*z<h;z++)
+   for(int x=z;x<w-z;x++)
+    for(int y=z;y<h-z;y++) {Tile t={2*x,2*y,z,0}; out.push_back(t);}
+  if (out.size()%2) out.pop_back();   //the top one, when there is an odd count
+  return out;
+}
+
+void bench(const char *name, const Tiles &layout, int deals, Jobs &jobs)
+{
+  Tiles b=layout;
+  Solver solver;
+  int solved=0, none=0, stuck=0;
+  long long nodes=0;
+  double tDeal=0, tSolve=0, tPar=0, worst=0;
+  uint32_t seed=12345;
+
+  for(int d=0;d<deals;d++)
+  {
+    double t0=now();
+    while(!deal(b, seed)) stuck++;
+    int perm[43];
+    for(int k=0;k<43;k++) perm[k]=k;
+    for(int k=34;k>1;k--) std::swap(perm[k], perm[1+xorshift(seed)%k]);
+    for(auto &t: b.tiles) t.kind=perm[t.kind];
+    b.reset();
+    double t1=now();
+    int r=solver.run(b, 2000000);
+    double t2=now();
+    std::vector<Pair> path;
+    solve(jobs, b, path, 2000000);
+    double t3=now();
+
+    tDeal+=t1-t0; tSolve+=t2-t1; tPar+=t3-t2;
+    worst=std::max(worst, t2-t1);
+    nodes+=solver.nodes;
+    solved += r==1; none += r==0;
+  }
+
+  printf("%-16s %5d tiles  %6.0f deals/s (%d stuck)  solved %d/%d, gave up %d  %8.0f nodes  %6.2f ms avg  %7.2f ms worst  pool %6.2f ms  %.2fM nodes/s\n",
+         name, b.size(), deals/tDeal, stuck, solved, deals, deals-solved-none, double(nodes)/deals,
+         1000*tSolve/deals, 1000*worst, 1000*tPar/deals, nodes/tSolve/1e6);
+}
+
+int main(int argc, char *argv[])
+{
+  int deals   = argc>1 ? atoi(argv[1]) : 200;
+  int threads = argc>2 ? atoi(argv[2]) : std::thread::hardware_concurrency();
+  Jobs jobs(threads);
+
+  Tiles map;
+  if (!map.load("files/map.txt")) {printf("can't read files/map.txt\n"); return 1;}
+  printf("%d threads\n", threads);
+  bench("map.txt", map, deals, jobs);
+
+  Tiles big;
+  big.build(tiled(map,2,1));   bench("map.txt x2", big, deals, jobs);
+  big.build(tiled(map,2,2));   bench("map.txt x4", big, deals/4+1, jobs);
+  big.build(pyramid(16,10));   bench("pyramid 16x10", big, deals, jobs);
+  big.build(pyramid(30,20));   bench("pyramid 30x20", big, deals/4+1, jobs);
+  return 0;
+}
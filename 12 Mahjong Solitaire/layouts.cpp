@@ -0,0 +1,36 @@
+// Layout compiler: text layouts in, one binary pack out, so the game
+// starts without parsing anything:
+//   g++ -std=c++11 -O2 layouts.cpp -o layouts
+//   ./layouts files/layouts.bin files/map.txt files/pyramid.txt files/towers.txt
+// A text layout has one digit per cell, the height of the stack there
+// (see Tiles::load); the layout is named after its file.
+#include <cstdio>
+#include "Layouts.hpp"
+
+int main(int argc, char *argv[])
+{
+  if (argc<3) {printf("usage: layouts out.bin layout.txt...\n"); return 1;}
+
+  std::vector<std::string> names;
+  std::vector<Tiles> layouts;
+  for(int i=2;i<argc;i++)
+  {
+    std::string name=argv[i];
+    name=name.substr(name.find_last_of("/\\")+1);
+    name=name.substr(0, name.find('.'));
+
+    Tiles t;
+    if (!t.load(argv[i])) {printf("can't read %s\n", argv[i]); return 1;}
+    if (t.size()%2 || t.size()>65535) {printf("%s: %d tiles, needs an even count up to 65534\n", argv[i], t.size()); return 1;}
+    if (name.size()>23) name.resize(23);
+    printf("%-12s %4d tiles %5d links\n", name.c_str(), t.size(), int(t.links.size()));
+    names.push_back(name);
+    layouts.push_back(t);
+  }
+
+  if (!writePack(argv[1], names, layouts)) {printf("can't write %s\n", argv[1]); return 1;}
+  Pack pack;
+  if (!pack.open(argv[1])) {printf("%s doesn't read back\n", argv[1]); return 1;}
+  printf("%d layouts, %d bytes\n", pack.count(), int(pack.size));
+  return 0;
+}
@@ -1,25 +1,19 @@
 #include <SFML/Graphics.hpp>
-#include <fstream>
 #include <time.h>
+#include "Solver.hpp"
+#include "Layouts.hpp"
+#include "Pick.hpp"
 using namespace sf;
 
-int field[50][50][50] = {0};
+Tiles board;
+Jobs jobs;
 
-int& f(int x,int y,int z){return field[y+2][x+2][z];}
-int& f(Vector3i v){return f(v.x,v.y,v.z);}
-
-
-bool isOpen(int x,int y,int z)
+// title bar: moves left on the table, or how the game stands
+std::string status(int left)
 {
-  for(int i=-1;i<=1;i++)
-   for(int j=-1;j<=1;j++)
-    if (f(x+2,y+i,z)>0 && f(x-2,y+j,z)>0) return 0;
-
-  for(int i=-1;i<=1;i++)
-   for(int j=-1;j<=1;j++)
-    if ( f(x+i,y+j,z+1)>0 ) return 0;
-
-  return 1;
+  if (!left) return "Mahjong Solitaire! Cleared!";
+  if (!board.pairs) return "Mahjong Solitaire! No moves left - right click to undo";
+  return "Mahjong Solitaire! " + std::to_string(board.pairs) + " moves, H for a hint, L for another layout";
 }
 
 
@@ -36,43 +30,30 @@ int main()
 	int w=48, h=66;
 	int stepX=w/2-2, stepY=h/2-2;
 	float offX=4.6, offY=7.1; // z offset
-    Vector3i v1,v2;
-    std::vector<Vector3i> moves;
-
-
-    ////load from file////
-    std::fstream myfile("files/map.txt");
-    for(int y=0;y<18;y++)
-     for(int x=0;x<30;x++)
-      {
-        char a;  myfile >> a;
-        int n = a - '0';
-        for(int z=0;z<n;z++)
-          if (f(x-1,y-1,z)) f(x-1,y,z)=f(x,y-1,z)=0;
-          else f(x,y,z)=1;
-      }
+    int sel=-1; //selected tile
+    std::vector<int> moves;
+    Pair hint={-1,-1};
+    Picker picker(stepX,stepY,offX,offY,30,0); // 30 - desk offset
 
-    ////create map//////
-    for(int k=1;;k++)
-    {
-     std::vector<Vector3i> opens;
-     for(int z=0;z<10;z++)
-      for(int y=0;y<18;y++)
-       for(int x=0;x<30;x++)
-        if (f(x,y,z)>0 && isOpen(x,y,z)) opens.push_back(Vector3i(x,y,z));
-
-     int n=opens.size();
-     if (n<2) break;
-     int a=0,b=0;
-     while(a==b){a=rand()%n;b=rand()%n;}
-     f(opens[a])=-k;  if (k>34) k++;
-     f(opens[b])=-k;
-     k%=42;
-    }
 
-    for(int z=0;z<10;z++)
-     for(int y=0;y<18;y++)
-      for(int x=0;x<30;x++) f(x,y,z)*=-1;
+    ////load layouts////
+    Pack pack;
+    int layout=0;
+    if (pack.open("files/layouts.bin")) pack.get(layout, board);
+    else board.load("files/map.txt"); //no pack built
+
+    ////create map//////
+    uint32_t seed = rand();
+    Helper helper(jobs); //deals and hints come in a later frame
+    bool dealing = false;
+    auto newGame = [&]()
+     {
+       helper.newDeal(board, seed);
+       dealing = true;
+       moves.clear(); sel=-1; hint.a=-1;
+       app.setTitle("Mahjong Solitaire! Dealing...");
+     };
+    newGame();
 
 
     while (app.isOpen())
@@ -89,46 +70,75 @@ int main()
                   {
                     int n = moves.size();
 					if (n==0) continue;
-                    f(moves[n-1])*=-1; moves.pop_back();
-                    f(moves[n-2])*=-1; moves.pop_back();
+                    helper.cancel(); //a hint for the old position is no use
+                    board.restore(moves[n-1]); moves.pop_back();
+                    board.restore(moves[n-2]); moves.pop_back();
+                    hint.a=-1;
+                    app.setTitle(status(board.size()-moves.size()));
+                  }
+
+            if (e.type == Event::KeyPressed)
+				if (e.key.code == Keyboard::L && pack.count()>1)
+                  {
+                    layout = (layout+1)%pack.count();
+                    pack.get(layout, board);
+                    newGame();
+                  }
+
+            if (e.type == Event::KeyPressed)
+				if (e.key.code == Keyboard::H && !dealing && !helper.busy(Helper::Hinting))
+                  {
+                    helper.findHint(board);
+                    app.setTitle("Mahjong Solitaire! Looking for a hint...");
                   }
 
    			if (e.type == Event::MouseButtonPressed)
-				if (e.key.code == Mouse::Left)
-                  for(int z=0;z<10;z++)
+				if (e.key.code == Mouse::Left && !dealing)
                    {
-                     Vector2i pos = Mouse::getPosition(app) - Vector2i(30,0); // 30 - desk offset
-                     int x = (pos.x-z*offX)/stepX;
-                     int y = (pos.y+z*offY)/stepY;
+                     Vector2i pos = Mouse::getPosition(app);
+                     int t = picker.pick(board, pos.x, pos.y); //topmost open tile under the mouse
 
-                     for(int i=0;i<2;i++)
-                      for(int j=0;j<2;j++)
-                        if (f(x-i,y-j,z)>0 && isOpen(x-i,y-j,z))
-                           v1=Vector3i(x-i,y-j,z);
+                     if (t<0 || t==sel) continue;
 
-                     if (v1==v2) continue;
-
-                     int a=f(v1),b=f(v2);
-                     if ( a==b || (a>34 && a<39 && b>34 && b<39) || (a>=39 && b>=39) )
+                     if (sel>=0 && match(board.tiles[t].kind, board.tiles[sel].kind))
                         {
-                         f(v1)*=-1; moves.push_back(v1);
-                         f(v2)*=-1; moves.push_back(v2);
+                         helper.cancel();
+                         board.remove(t); moves.push_back(t);
+                         board.remove(sel); moves.push_back(sel);
+                         t=-1; hint.a=-1;
+                         app.setTitle(status(board.size()-moves.size()));
                         }
-                     v2=v1;
+                     sel=t;
                    }
         }
 
+       Helper::Task done = helper.poll();
+       if (done==Helper::Dealing)
+         {
+          board = helper.board; seed = helper.seed;
+          dealing = false;
+          picker.build(board);
+          app.setTitle(status(board.size()));
+         }
+       if (done==Helper::Hinting)
+         {
+          hint = helper.move;
+          if (helper.result==1) app.setTitle(status(board.size()-moves.size()));
+          if (helper.result==0) app.setTitle("Mahjong Solitaire! No way out from here - right click to undo");
+          if (helper.result<0) app.setTitle("Mahjong Solitaire! Too many ways to look at, no hint");
+         }
+
        app.clear();
        app.draw(sBackground);
-       for(int z=0;z<10;z++)
-        for(int x=30;x>=0;x--)
-         for(int y=0;y<18;y++)
+       for(int i=0;i<board.size() && !dealing;i++)
          {
-            int k = f(x,y,z)-1;
-            if (k<0) continue;
+            if (!board.live[i]) continue;
+            const Tile &a = board.tiles[i];
+            int k = a.kind-1;
             s.setTextureRect(IntRect(k*w,0,w,h));
-            if (isOpen(x,y,z)) s.setTextureRect(IntRect(k*w,h,w,h));
-            s.setPosition(x*stepX + z*offX, y*stepY - z*offY);
+            if (board.isOpen(i)) s.setTextureRect(IntRect(k*w,h,w,h));
+            s.setColor(i==hint.a || i==hint.b ? Color(255,230,120) : Color::White);
+            s.setPosition(a.x*stepX + a.z*offX, a.y*stepY - a.z*offY);
             s.move(30,0); //desk offset
             app.draw(s);
           }
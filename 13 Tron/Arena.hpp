@@ -0,0 +1,93 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include <bitset>
+
+// Which pixels hold a trail: one bit each, rows packed in 64-bit words, so
+// a 600x480 arena is 36 KB instead of 288 KB of bools.
+struct Arena
+{
+  int w, h, stride;               //stride: words per row
+  std::vector<uint64_t> bits;
+
+  Arena(int W=0, int H=0) : w(W), h(H), stride((W+63)/64), bits(size_t(stride)*H, 0) {}
+
+  bool test(int x,int y) const {return bits[size_t(y)*stride + (x>>6)] >> (x&63) & 1;}
+  void set(int x,int y) {bits[size_t(y)*stride + (x>>6)] |= uint64_t(1) << (x&63);}
+  void clear() {std::fill(bits.begin(), bits.end(), 0);}
+
+  // Bit sets over the same rows: `a` and the cells next to it (4 ways,
+  // wrapping round the edges) go into `out`. A whole row of 64 cells moves
+  // in a few shifts, so a flood fill costs a pass of this per step. Only
+  // `rows` rows from y0 on (wrapping) are done; `a` must be empty outside
+  // them except for the rows just above and below.
+  void spread(const uint64_t *a, uint64_t *out, int y0=0, int rows=-1) const
+  {
+    if (rows<0 || rows>h) rows=h;
+    int last=(w-1)>>6;
+    uint64_t tail = (w&63) ? (uint64_t(1)<<(w&63))-1 : ~uint64_t(0);
+    int y=(y0%h+h)%h;
+    for(int i=0;i<rows;i++,y = y+1<h ? y+1 : 0)
+    {
+      const uint64_t *r=a+size_t(y)*stride;
+      const uint64_t *up=a+size_t(y ? y-1 : h-1)*stride, *down=a+size_t(y+1<h ? y+1 : 0)*stride;
+      uint64_t *o=out+size_t(y)*stride;
+      for(int k=0;k<stride;k++)
+      {
+        uint64_t v=r[k];
+        uint64_t right = v<<1 | (k ? r[k-1]>>63 : 0);
+        uint64_t left  = v>>1 | (k+1<stride ? r[k+1]<<63 : 0);
+        o[k] = v|left|right|up[k]|down[k];
+      }
+      if (r[last]>>((w-1)&63) & 1) o[0]|=1;                        //x=w-1 wraps to 0
+      if (r[0]&1) o[last]|=uint64_t(1)<<((w-1)&63);               //and 0 to w-1
+      o[last]&=tail;
+    }
+  }
+};
+
+inline int count(const uint64_t *a, size_t n)
+{
+  int c=0;
+  for(size_t i=0;i<n;i++) c+=std::bitset<64>(a[i]).count();
+  return c;
+}
+
+// Straight piece of a trail, both ends included
+struct Segment {int x0, y0, x1, y1;};
+
+// A light cycle. Its trail is a list of segments: a new one starts on a
+// turn or when it wraps round an edge, otherwise the last one just grows,
+// so a trail is a handful of segments however long it gets.
+struct Rider
+{
+  int x, y, dir;                  //dir: 0 down, 1 left, 2 right, 3 up
+  std::vector<Segment> trail;
+  int trailDir;                   //direction the last segment grows in
+
+  void start(int X,int Y,int d) {x=X; y=Y; dir=d; trail.clear(); trailDir=-1;}
+
+  void tick(int W,int H)
+  {
+    if (dir==0) y+=1;
+    if (dir==1) x-=1;
+    if (dir==2) x+=1;
+    if (dir==3) y-=1;
+
+    bool wrapped = x<0 || y<0 || x>=W || y>=H;
+    if (x>=W) x=0;
+    if (x<0) x=W-1;
+    if (y>=H) y=0;
+    if (y<0) y=H-1;
+
+    if (!wrapped && dir==trailDir) {trail.back().x1=x; trail.back().y1=y; return;}
+    Segment s={x,y,x,y};
+    trail.push_back(s);
+    trailDir=dir;
+  }
+};
+
+#endif
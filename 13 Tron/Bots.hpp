@@ -0,0 +1,176 @@
+#ifndef BOTS_H
+#define BOTS_H
+
+#include <vector>
+#include <string>
+#include <cstdlib>
+#include "Match.hpp"
+
+const int stepX[4]={0,-1,1,0}, stepY[4]={1,0,0,-1};   //by dir: down, left, right, up
+
+// Computer rider. For each way it can go it scores the cell it would move
+// to and takes the best, going straight or at random on a tie:
+//
+//   Flood    cells it can still reach from there, so it doesn't wall
+//            itself in
+//   Voronoi  cells it reaches before anybody else, minus the best of the
+//            others, so it also cuts the others off
+//
+// Both are breadth first searches run on the arena bits, a whole ring of
+// cells per step (Arena::spread), limited to `depth` steps. Each search
+// only touches the rows it could have got to so far, so a shallow one is
+// cheap on a big arena too. The buffers are all zero between searches:
+// each one clears just the rows it touched before it returns.
+struct Bot
+{
+  enum Kind {Flood, Voronoi};
+  int kind, depth;
+  uint32_t seed;
+  std::vector<uint64_t> claimed, once, twice, seen, grown;
+  std::vector<std::vector<uint64_t> > front, next;
+  std::vector<int> lo, rows, cells;
+  std::vector<char> on;
+
+  Bot(int k=Voronoi, int d=64, uint32_t s=1) : kind(k), depth(d), seed(s ? s : 1) {}
+
+  // "flood", "voronoi", optionally with the depth: "voronoi:32"
+  static bool parse(const std::string &s, Bot &b)
+  {
+    std::string name=s.substr(0, s.find(':'));
+    if (name=="flood") b.kind=Flood;
+    else if (name=="voronoi") b.kind=Voronoi;
+    else return false;
+    if (s.find(':')!=std::string::npos) b.depth=atoi(s.c_str()+s.find(':')+1);
+    return b.depth>0;
+  }
+
+  std::string name() const {return std::string(kind==Flood ? "flood" : "voronoi") + ":" + std::to_string(depth);}
+
+  // f(word) for every word of the rows lo .. lo+n-1, wrapping
+  template<class F> static void each(const Arena &a, int lo, int n, F f)
+  {
+    size_t y=(lo%a.h+a.h)%a.h;
+    for(int i=0;i<n;i++,y = y+1<size_t(a.h) ? y+1 : 0)
+      for(int k=0;k<a.stride;k++) f(y*a.stride+k);
+  }
+
+  // one step further reaches one row further each way
+  static void grow(const Arena &a, int &lo, int &n) {if (n+2>=a.h) {lo=0; n=a.h;} else {lo--; n+=2;}}
+
+  static void mark(std::vector<uint64_t> &v, const Arena &a, int x, int y) {v[size_t(y)*a.stride+(x>>6)] |= uint64_t(1)<<(x&63);}
+
+  // zeroed only when the arena size changed
+  static void fit(std::vector<uint64_t> &v, size_t N) {if (v.size()!=N) v.assign(N,0);}
+  static void clear(std::vector<uint64_t> &v, const Arena &a, int lo, int n) {each(a, lo, n, [&](size_t k) {v[k]=0;});}
+
+  // free cells reachable from (x,y)
+  int flood(const Match &m, int x, int y)
+  {
+    const Arena &a=m.field;
+    fit(seen, a.bits.size()); fit(grown, a.bits.size());
+    mark(seen, a, x, y);
+    int l=y, n=1;
+    for(int step=0;step<depth;step++)
+    {
+      grow(a, l, n);
+      a.spread(&seen[0], &grown[0], l, n);
+      bool changed=false;
+      each(a, l, n, [&](size_t k) {grown[k]&=~a.bits[k]; changed |= grown[k]!=seen[k];});
+      seen.swap(grown);
+      if (!changed) break;
+    }
+    int got=0;
+    each(a, l, n, [&](size_t k) {got+=std::bitset<64>(seen[k]).count();});
+    clear(seen, a, l, n); clear(grown, a, l, n);
+    return got;
+  }
+
+  // cells `me` (moved to x,y) gets to first, less the most any other one
+  // gets first; cells reached by two at once belong to nobody
+  int voronoi(const Match &m, int me, int x, int y)
+  {
+    const Arena &a=m.field;
+    size_t N=a.bits.size();
+    int P=m.riders.size();
+    claimed=a.bits; fit(once, N); fit(twice, N);
+    front.resize(P); next.resize(P);
+    lo.assign(P,0); rows.assign(P,0); cells.assign(P,0); on.assign(P,0);
+    for(int p=0;p<P;p++)
+    {
+      if (!m.alive[p]) continue;
+      int px = p==me ? x : m.riders[p].x, py = p==me ? y : m.riders[p].y;
+      fit(front[p], N); fit(next[p], N);
+      mark(front[p], a, px, py); mark(claimed, a, px, py);
+      lo[p]=py; rows[p]=1; on[p]=1;
+    }
+
+    for(int step=0;step<depth;step++)
+    {
+      bool any=false;
+      for(int p=0;p<P;p++)
+      {
+        if (!on[p]) continue;
+        uint64_t *nx=&next[p][0];
+        grow(a, lo[p], rows[p]);
+        a.spread(&front[p][0], nx, lo[p], rows[p]);
+        each(a, lo[p], rows[p], [&](size_t k) {nx[k]&=~claimed[k]; twice[k]|=once[k]&nx[k]; once[k]|=nx[k];});
+      }
+      for(int p=0;p<P;p++)
+      {
+        if (!on[p]) continue;
+        uint64_t *f=&front[p][0], *nx=&next[p][0];
+        int got=0;
+        each(a, lo[p], rows[p], [&](size_t k) {f[k]=nx[k]&~twice[k]; claimed[k]|=nx[k]; got+=std::bitset<64>(f[k]).count();});
+        cells[p]+=got;
+        any |= got>0;
+        if (!got) on[p]=2;   //done, its rows still get cleared below
+      }
+      for(int p=0;p<P;p++)
+      {
+        if (!on[p]) continue;
+        each(a, lo[p], rows[p], [&](size_t k) {once[k]=twice[k]=0;});
+        if (on[p]==2) on[p]=0;
+      }
+      if (!any) break;
+    }
+
+    for(int p=0;p<P;p++)
+      if (m.alive[p]) {clear(front[p], a, lo[p], rows[p]); clear(next[p], a, lo[p], rows[p]);}
+
+    int best=0;
+    for(int p=0;p<P;p++) if (p!=me) best=std::max(best, cells[p]);
+    return cells[me]-best;
+  }
+
+  // direction for rider `me` this tick
+  int choose(const Match &m, int me)
+  {
+    const Rider &r=m.riders[me];
+    int best=r.dir;
+    long long bestKey=0;
+    bool first=true;
+    for(int d=0;d<4;d++)
+    {
+      if (d==opposite(r.dir)) continue;
+      int x=(r.x+stepX[d]+m.W)%m.W, y=(r.y+stepY[d]+m.H)%m.H;
+      long long score;
+      if (m.field.test(x,y)) score=-1000000;
+      else
+      {
+        score = kind==Flood ? flood(m,x,y) : voronoi(m,me,x,y);
+        for(size_t p=0;p<m.riders.size();p++)   //someone else may go there too: both crash
+        {
+          if (int(p)==me || !m.alive[p]) continue;
+          int ex=std::abs(m.riders[p].x-x), ey=std::abs(m.riders[p].y-y);
+          ex=std::min(ex, m.W-ex); ey=std::min(ey, m.H-ey);
+          if (ex+ey==1) score-=depth;
+        }
+      }
+      long long key = score*8 + (d==r.dir)*4 + xorshift(seed)%4;
+      if (first || key>bestKey) {best=d; bestKey=key; first=false;}
+    }
+    return best;
+  }
+};
+
+#endif
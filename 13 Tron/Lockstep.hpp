@@ -0,0 +1,197 @@
+#ifndef LOCKSTEP_H
+#define LOCKSTEP_H
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include "Match.hpp"
+#include "Transport.hpp"
+
+// Network play without sending any game state. Every peer runs the same
+// Match and only key presses go over the wire; a tick is simulated once
+// every peer's input for it is in. Local input is for `delay` ticks
+// ahead, so on a good connection the others' has arrived by the time it's
+// needed and nobody waits.
+//
+// A packet repeats all input the receiver hasn't acknowledged yet, so a
+// lost one is covered by the next and nothing is ever resent on purpose.
+// Each packet also carries the sender's hash for its latest tick; when a
+// peer's own hash for that tick differs, `desync` keeps that tick. Only the
+// latest tick is compared, so it is where the difference was noticed: at
+// or some ticks after the one where the games first went apart.
+//
+// First the peers say hello: each one sends a hash of the address list
+// and its own start time until it has everybody's. The match seed and the
+// session are then a hash of the list and all the start times, the same
+// on every peer and new for every match, and the match is dealt from it.
+// Hellos go on to a peer until its first input packet shows it has ours.
+//
+// Hello, little endian:
+//   'T' 'H'  from  players        4 bytes
+//   link                          uint32, hash of the address list
+//   start                         uint32, the sender's start time
+//
+// Input packet:
+//   'T' 'L'  from  players        4 bytes
+//   session                       uint32, from the start times
+//   ack                           uint32, ticks of the receiver's input the sender has
+//   first                         uint32, tick of the first input below
+//   count                         uint8
+//   hashTick, hash                uint32 + uint64
+//   input[count]                  a nibble each, low one first: dir 0..3, 4 for none
+const int noInput = 4;
+const int packetHeader = 29;   //bytes before the inputs
+const int helloSize = 12;
+const int hashRing = 1024;     //own hashes kept to check the others' against
+
+struct Lockstep
+{
+  Match *game;
+  Transport *net;
+  int me, players, delay;
+  uint32_t link, session;
+  std::vector<uint32_t> starts;                //start time of each peer
+  std::vector<char> heard, joined;             //have its start time; it has ours
+  bool connected;                              //every start time in and the match dealt
+  std::vector<std::vector<uint8_t> > inputs;   //inputs[p][t]: what p pressed for tick t
+  std::vector<int> acked;                      //ticks of my input each peer has
+  std::vector<uint64_t> hashes;                //hashes[t%hashRing]: game hash when ticks==t
+  int desync;                                  //tick the desync was detected at (at or after the divergence), -1 none
+  long long bytesOut, packetsOut, packetsIn, rejected;
+
+  // `link` is hashOf() the address list, `start` when this peer started;
+  // the match in `g` is dealt again once every peer's start is in
+  Lockstep(Match &g, Transport &t, int id, int delayTicks, uint32_t linkHash, uint32_t start)
+    : game(&g), net(&t), me(id), players(g.riders.size()), delay(delayTicks), link(linkHash), session(0),
+      starts(players, 0), heard(players, 0), joined(players, 0), connected(false),
+      inputs(players), acked(players, 0), hashes(hashRing, 0), desync(-1),
+      bytesOut(0), packetsOut(0), packetsIn(0), rejected(0)
+  {
+    inputs[me].assign(delay, noInput);   //nothing pressed in the first ticks
+    starts[me]=start; heard[me]=joined[me]=1;
+  }
+
+  static uint32_t hashOf(const std::vector<std::string> &addresses)
+  {
+    uint64_t h=addresses.size();
+    for(const std::string &a: addresses)
+    {
+      for(char c: a) h=splitmix(h^uint8_t(c));
+      h=splitmix(h^0x100);   //end of one address
+    }
+    return uint32_t(h);
+  }
+
+  // every start in: seed and session for this match, and the match itself
+  void connect()
+  {
+    uint64_t h=splitmix(link);
+    for(uint32_t s: starts) h=splitmix(h^s);
+    session=uint32_t(h>>32);
+    game->reset(game->W, game->H, players, uint32_t(h));
+    hashes[game->ticks%hashRing]=game->hash();
+    connected=true;
+  }
+
+  int tick() const {return game->ticks;}
+
+  // room for one more local input: one per tick, `delay` ahead
+  bool canInput() const {return connected && int(inputs[me].size()) <= tick()+delay;}
+  void input(int dir) {inputs[me].push_back(dir>=0 && dir<4 ? dir : noInput);}
+
+  bool ready() const
+  {
+    if (!connected) return false;
+    for(int p=0;p<players;p++) if (int(inputs[p].size())<=tick()) return false;
+    return true;
+  }
+
+  void advance()
+  {
+    int t=tick();
+    for(int p=0;p<players;p++)
+      if (inputs[p][t]!=noInput && game->alive[p]) game->steer(p, inputs[p][t]);
+    game->step();
+    hashes[tick()%hashRing]=game->hash();
+  }
+
+  static void put32(uint8_t *p, uint32_t v) {for(int i=0;i<4;i++) p[i]=v>>(8*i);}
+  static uint32_t get32(const uint8_t *p) {return p[0] | p[1]<<8 | p[2]<<16 | uint32_t(p[3])<<24;}
+
+  // hello to every peer not known to have my start, then my
+  // unacknowledged input to every other peer
+  void send()
+  {
+    uint8_t buf[packetHeader+128];
+    for(int to=0;to<players;to++)
+    {
+      if (joined[to]) continue;
+      buf[0]='T'; buf[1]='H'; buf[2]=me; buf[3]=players;
+      put32(buf+4, link); put32(buf+8, starts[me]);
+      net->send(to, buf, helloSize);
+      bytesOut+=helloSize; packetsOut++;
+    }
+    if (!connected) return;
+
+    uint64_t h=hashes[tick()%hashRing];
+    for(int to=0;to<players;to++)
+    {
+      if (to==me) continue;
+      int first=acked[to], count=std::min(int(inputs[me].size())-first, 255);
+      buf[0]='T'; buf[1]='L'; buf[2]=me; buf[3]=players;
+      put32(buf+4, session);
+      put32(buf+8, inputs[to].size());
+      put32(buf+12, first);
+      buf[16]=count;
+      put32(buf+17, tick());
+      put32(buf+21, uint32_t(h)); put32(buf+25, uint32_t(h>>32));
+      memset(buf+packetHeader, 0, (count+1)/2);
+      for(int i=0;i<count;i++) buf[packetHeader+i/2] |= inputs[me][first+i] << (i%2*4);
+      int n=packetHeader+(count+1)/2;
+      net->send(to, buf, n);
+      bytesOut+=n; packetsOut++;
+    }
+  }
+
+  // everything that came in; true if anything was new
+  bool poll()
+  {
+    uint8_t buf[packetHeader+256];
+    bool fresh=false;
+    for(size_t n; (n=net->receive(buf, sizeof(buf)))>0;)
+    {
+      if (n==helloSize && buf[0]=='T' && buf[1]=='H')
+      {
+        if (buf[3]!=players || buf[2]>=players || buf[2]==me || get32(buf+4)!=link) {rejected++; continue;}
+        if (!heard[buf[2]]) {starts[buf[2]]=get32(buf+8); heard[buf[2]]=1;}
+        continue;
+      }
+      if (!connected) continue;   //the sender is a step ahead, it sends again
+      if (n<packetHeader || buf[0]!='T' || buf[1]!='L' || buf[3]!=players || buf[2]>=players || buf[2]==me
+          || get32(buf+4)!=session || n<packetHeader+(size_t(buf[16])+1)/2) {rejected++; continue;}
+      packetsIn++;
+      int from=buf[2], first=get32(buf+12), count=buf[16];
+      joined[from]=1;
+      acked[from]=std::max(acked[from], std::min(int(get32(buf+8)), int(inputs[me].size())));
+
+      std::vector<uint8_t> &in=inputs[from];
+      for(int t=int(in.size());t<first+count && t>=first;t++)
+      {
+        int i=t-first, v=buf[packetHeader+i/2] >> (i%2*4) & 15;
+        if (v>noInput) {rejected++; break;}
+        in.push_back(v);
+        fresh=true;
+      }
+
+      int ht=get32(buf+17);
+      uint64_t h=get32(buf+21) | uint64_t(get32(buf+25))<<32;
+      if (ht<=tick() && ht>tick()-hashRing && hashes[ht%hashRing]!=h && (desync<0 || ht<desync)) desync=ht;
+    }
+    if (!connected && std::count(heard.begin(), heard.end(), 1)==players) connect();
+    return fresh;
+  }
+};
+
+#endif
@@ -0,0 +1,92 @@
+#ifndef MATCH_H
+#define MATCH_H
+
+#include <vector>
+#include <cstdint>
+#include "Arena.hpp"
+#include "../common/Random.hpp"
+
+inline int opposite(int dir) {return 3-dir;}   //0 down, 1 left, 2 right, 3 up
+
+// One round of Tron for any number of riders, no graphics, no rand(): the
+// same seed always plays out the same, so matches can be replayed, run on
+// any thread, or kept in step over a network.
+//
+// Every tick all living riders move one cell at once. A rider crashes on
+// a cell that already holds a trail, and two riders entering the same cell
+// both crash. Crashed riders stop, their trails stay. The round is over
+// when at most one is left.
+struct Match
+{
+  int W, H;
+  Arena field;
+  std::vector<Rider> riders;
+  std::vector<char> alive;
+  uint32_t seed;
+  int ticks;
+  uint64_t trails;   //sum of a key per trail cell, so hash() needn't read the arena
+
+  Match(int w=600, int h=480, int players=2, uint32_t s=1) {reset(w,h,players,s);}
+
+  void reset(int w, int h, int players, uint32_t s)
+  {
+    W=w; H=h; field=Arena(w,h); ticks=0; trails=0;
+    seed = s ? s : 1;
+    riders.assign(players, Rider());
+    alive.assign(players, 1);
+    for(auto &r: riders) {int x=xorshift(seed)%W, y=xorshift(seed)%H; r.start(x, y, xorshift(seed)%4);}
+  }
+
+  int living() const {int n=0; for(char a: alive) n+=a; return n;}
+  bool over() const {return living()<=1;}
+
+  // last rider standing, -1 while it's on or when the last ones went together
+  int winner() const
+  {
+    if (!over()) return -1;
+    for(size_t i=0;i<alive.size();i++) if (alive[i]) return i;
+    return -1;
+  }
+
+  // turns that would put a rider back on its own trail are ignored, like the keys
+  void steer(int i, int dir) {if (dir>=0 && dir<4 && dir!=opposite(riders[i].dir)) riders[i].dir=dir;}
+
+  void step()
+  {
+    int n=riders.size();
+    for(int i=0;i<n;i++) if (alive[i]) riders[i].tick(W,H);
+
+    std::vector<char> crash(n, 0);
+    for(int i=0;i<n;i++)
+    {
+      if (!alive[i]) continue;
+      const Rider &a=riders[i];
+      if (field.test(a.x,a.y)) crash[i]=1;
+      for(int j=i+1;j<n;j++)
+        if (alive[j] && riders[j].x==a.x && riders[j].y==a.y) crash[i]=crash[j]=1;
+    }
+    for(int i=0;i<n;i++)
+      if (alive[i])
+      {
+        field.set(riders[i].x, riders[i].y);
+        trails+=splitmix(uint64_t(riders[i].y)*W+riders[i].x);
+      }
+    for(int i=0;i<n;i++) if (crash[i]) alive[i]=0;
+    ticks++;
+  }
+
+  // the whole state in 64 bits; machines playing the same match compare
+  // these to find out they went apart
+  uint64_t hash() const
+  {
+    uint64_t h=splitmix(trails^ticks);
+    for(size_t i=0;i<riders.size();i++)
+    {
+      const Rider &r=riders[i];
+      h=splitmix(h ^ uint64_t(r.x)<<32 ^ uint64_t(r.y)<<8 ^ r.dir<<1 ^ alive[i]);
+    }
+    return h;
+  }
+};
+
+#endif
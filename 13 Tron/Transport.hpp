@@ -0,0 +1,166 @@
+#ifndef TRANSPORT_H
+#define TRANSPORT_H
+
+#include <vector>
+#include <queue>
+#include <deque>
+#include <algorithm>
+#include <string>
+#include <cstdint>
+#include <cstring>
+#include "Match.hpp"
+
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// Unreliable datagrams between the peers of a game, peers numbered from
+// 0. Packets may come late, out of order or not at all; Lockstep copes.
+struct Transport
+{
+  virtual ~Transport() {}
+  virtual void send(int to, const uint8_t *p, size_t n) = 0;
+  virtual size_t receive(uint8_t *p, size_t max) = 0;   //0 when nothing is waiting
+};
+
+// In-process network for tests: every packet is held back by `latency`
+// plus up to `jitter` ms and dropped `loss` percent of the time. Time only
+// moves when the owner sets `now`, so a test run is the same every time.
+struct Wire
+{
+  struct Packet
+  {
+    double at; long long order; int to;
+    std::vector<uint8_t> data;
+    bool operator<(const Packet &o) const {return at!=o.at ? at>o.at : order>o.order;}   //earliest on top
+  };
+
+  double now, latency, jitter, loss;
+  uint32_t seed;
+  long long sent, dropped, bytes;
+  std::priority_queue<Packet> queue;            //in flight
+  std::vector<std::deque<Packet> > due;         //arrived, by peer
+
+  Wire(double lat=0, double jit=0, double lossPercent=0, uint32_t s=1)
+    : now(0), latency(lat), jitter(jit), loss(lossPercent), seed(s ? s : 1), sent(0), dropped(0), bytes(0) {}
+
+  double random() {return xorshift(seed)/4294967296.0;}
+
+  void post(int to, const uint8_t *p, size_t n)
+  {
+    sent++; bytes+=n;
+    if (random()*100<loss) {dropped++; return;}
+    Packet k;
+    k.at=now+latency+random()*jitter; k.order=sent; k.to=to;
+    k.data.assign(p, p+n);
+    queue.push(k);
+  }
+
+  // next packet for `me` that has arrived by now
+  size_t take(int me, uint8_t *p, size_t max)
+  {
+    while(!queue.empty() && queue.top().at<=now)
+    {
+      const Packet &k=queue.top();
+      if (int(due.size())<=k.to) due.resize(k.to+1);
+      due[k.to].push_back(k);
+      queue.pop();
+    }
+    if (int(due.size())<=me || due[me].empty()) return 0;
+    Packet &k=due[me].front();
+    size_t n=std::min(max, k.data.size());
+    memcpy(p, &k.data[0], n);
+    due[me].pop_front();
+    return n;
+  }
+};
+
+struct Loopback : Transport
+{
+  Wire *wire;
+  int me;
+
+  Loopback(Wire &w, int id) : wire(&w), me(id) {}
+  void send(int to, const uint8_t *p, size_t n) {wire->post(to, p, n);}
+  size_t receive(uint8_t *p, size_t max) {return wire->take(me, p, max);}
+};
+
+// UDP, one socket per peer, non-blocking. Not built on Windows yet, open()
+// fails there.
+struct Udp : Transport
+{
+  int fd;
+#ifndef _WIN32
+  std::vector<sockaddr_in> peers;
+#endif
+
+  Udp() : fd(-1) {}
+  ~Udp() {close();}
+
+  void close()
+  {
+#ifndef _WIN32
+    if (fd>=0) ::close(fd);
+#endif
+    fd=-1;
+  }
+
+  // listens on `port`; peers come in id order as "host:port", this one's
+  // own entry included (it is never sent to)
+  bool open(int port, const std::vector<std::string> &addresses)
+  {
+    close();
+#ifndef _WIN32
+    peers.clear();
+    for(const std::string &a: addresses)
+    {
+      size_t c=a.rfind(':');
+      if (c==std::string::npos) return false;
+      addrinfo hints, *res=0;
+      memset(&hints, 0, sizeof(hints));
+      hints.ai_family=AF_INET; hints.ai_socktype=SOCK_DGRAM;
+      if (getaddrinfo(a.substr(0,c).c_str(), a.substr(c+1).c_str(), &hints, &res)!=0 || !res) return false;
+      sockaddr_in sa;
+      memcpy(&sa, res->ai_addr, sizeof(sa));
+      freeaddrinfo(res);
+      peers.push_back(sa);
+    }
+
+    fd=socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd<0) return false;
+    sockaddr_in me;
+    memset(&me, 0, sizeof(me));
+    me.sin_family=AF_INET; me.sin_addr.s_addr=htonl(INADDR_ANY); me.sin_port=htons(port);
+    if (bind(fd, (sockaddr*)&me, sizeof(me))!=0 || fcntl(fd, F_SETFL, O_NONBLOCK)!=0) {close(); return false;}
+    return true;
+#else
+    (void)port; (void)addresses;
+    return false;
+#endif
+  }
+
+  void send(int to, const uint8_t *p, size_t n)
+  {
+#ifndef _WIN32
+    if (fd>=0 && to>=0 && to<int(peers.size())) sendto(fd, p, n, 0, (sockaddr*)&peers[to], sizeof(peers[to]));
+#endif
+  }
+
+  size_t receive(uint8_t *p, size_t max)
+  {
+#ifndef _WIN32
+    if (fd<0) return 0;
+    ssize_t n=recvfrom(fd, p, max, 0, 0, 0);
+    return n>0 ? n : 0;
+#else
+    return 0;
+#endif
+  }
+};
+
+#endif
@@ -0,0 +1,155 @@
+// Lockstep play between bots over a simulated network, all in one process:
+//   g++ -std=c++11 -O2 lockstep.cpp -o lockstep
+//   ./lockstep [players=2] [ticks=5000] [latency=40] [jitter=20] [loss=5] [delay=16] [desync=-1]
+//   ./lockstep udp [players=2] [ticks=1000] [port=40000] [delay=16]
+// Latency and jitter are in ms, loss in percent. Peers work like the
+// window: 60 frames a second, each makes up to 4 ticks of input, sends
+// one packet to every other peer and plays what it can. With desync=T one
+// peer's state is spoilt at tick T to show it gets caught, a few ticks
+// later. The udp run sends real packets through 127.0.0.1 in real time
+// instead.
+//
+// Reported: the tick rate reached, how often a peer's input buffer was
+// full (it had to wait for the others), packets and bytes per tick, how
+// long local input took to reach the game, and whether every peer ended
+// up in the same state.
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <memory>
+#include "Lockstep.hpp"
+#include "Bots.hpp"
+
+const double frameMs = 1000.0/60;
+const int speed = 4;   //ticks per frame
+
+double now() {return 1000*std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();}
+
+struct Peer
+{
+  Match game;
+  std::unique_ptr<Transport> net;
+  std::unique_ptr<Lockstep> lock;
+  Bot bot;
+  std::vector<double> sentAt;   //when the input for each tick was made
+  double lag, worst;            //input to game, ms
+  long long waits;
+};
+
+int main(int argc, char *argv[])
+{
+  bool udp = argc>1 && std::string(argv[1])=="udp";
+  int a = udp ? 2 : 1;
+  int players = argc>a ? atoi(argv[a]) : 2;
+  int ticks   = argc>a+1 ? atoi(argv[a+1]) : udp ? 1000 : 5000;
+  double latency=40, jitter=20, loss=5;
+  int port=40000, delay=16, desync=-1;
+  if (udp)
+  {
+    if (argc>4) port=atoi(argv[4]);
+    if (argc>5) delay=atoi(argv[5]);
+  }
+  else
+  {
+    if (argc>3) latency=atof(argv[3]);
+    if (argc>4) jitter=atof(argv[4]);
+    if (argc>5) loss=atof(argv[5]);
+    if (argc>6) delay=atoi(argv[6]);
+    if (argc>7) desync=atoi(argv[7]);
+  }
+  if (players<2 || players>8 || delay<1) {printf("2 to 8 players, delay at least 1\n"); return 1;}
+
+  Wire wire(latency, jitter, loss, 7);
+  std::vector<std::string> addresses;
+  for(int p=0;p<players;p++) addresses.push_back("127.0.0.1:"+std::to_string(port+p));
+
+  std::vector<Peer> peers(players);
+  for(int p=0;p<players;p++)
+  {
+    Peer &k=peers[p];
+    k.game.reset(600, 480, players, 1);   //dealt again once the peers have said hello
+    if (udp)
+    {
+      Udp *u=new Udp;
+      k.net.reset(u);
+      if (!u->open(port+p, addresses)) {printf("can't open udp port %d\n", port+p); return 1;}
+    }
+    else k.net.reset(new Loopback(wire, p));
+    k.lock.reset(new Lockstep(k.game, *k.net, p, delay, Lockstep::hashOf(addresses), udp ? uint32_t(now())+p : 1000+p));
+    k.bot=Bot(Bot::Flood, 24, p+1);
+    k.sentAt.assign(delay, 0);
+    k.lag=k.worst=0; k.waits=0;
+  }
+
+  // one pass per frame: input, send, receive, then play every tick that
+  // can be played
+  double start = udp ? now() : 0, clock=start;
+  long long frames=0;
+  bool done=false;
+  while(!done)
+  {
+    if (udp) {while(now()<clock) std::this_thread::sleep_for(std::chrono::microseconds(200));}
+    else wire.now=clock;
+    frames++;
+
+    done=true;
+    for(int p=0;p<players;p++)
+    {
+      Peer &k=peers[p];
+      Lockstep &l=*k.lock;
+      if (!l.canInput() && l.tick()<ticks) k.waits++;
+      for(int i=0;i<speed && l.canInput();i++)
+      {
+        l.input(k.game.alive[p] ? k.bot.choose(k.game,p) : -1);
+        k.sentAt.push_back(clock);
+      }
+      l.send();
+      l.poll();
+      while(l.ready() && l.tick()<ticks)
+      {
+        if (l.tick()==desync && p==1) k.game.trails++;   //spoil one peer
+        int t=l.tick();
+        l.advance();
+        if (t<int(k.sentAt.size()) && t>=delay)
+        {
+          double d=clock-k.sentAt[t];
+          k.lag+=d; k.worst=std::max(k.worst, d);
+        }
+      }
+      done &= l.tick()>=ticks;
+    }
+    clock+=frameMs;
+    if (frames>ticks*100LL) {printf("stuck\n"); break;}
+  }
+  // a few more rounds so the last hashes get compared
+  for(int r=0;r<int(2*(latency+jitter)/frameMs)+4;r++)
+  {
+    if (udp) std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    else wire.now+=frameMs;
+    for(auto &k: peers) {k.lock->send(); k.lock->poll();}
+  }
+
+  double seconds=(clock-start)/1000;
+  printf("%s, %d players, %d ticks, delay %d ticks (%.0f ms)", udp ? "udp 127.0.0.1" : "loopback", players, ticks, delay, delay*frameMs/speed);
+  if (!udp) printf(", latency %.0f+%.0f ms, %.1f%% loss", latency, jitter, loss);
+  printf("\n%.1f ticks/s of %.0f, run %.2f s\n", ticks/seconds, speed*1000/frameMs, seconds);
+  if (!udp) printf("wire: %lld packets, %lld dropped\n", wire.sent, wire.dropped);
+
+  bool same=true;
+  for(int p=0;p<players;p++)
+  {
+    Peer &k=peers[p];
+    Lockstep &l=*k.lock;
+    printf("peer %d: waited %5.1f%% of frames  %.2f packets/tick  %5.1f bytes/tick  %5.2f KB/s  input lag %5.1f ms avg %5.1f max  hash %016llx",
+           p, 100.0*k.waits/frames, double(l.packetsOut)/ticks, double(l.bytesOut)/ticks, l.bytesOut/seconds/1024,
+           k.lag/std::max(1,ticks-delay), k.worst, (unsigned long long)k.game.hash());
+    if (l.desync>=0) printf("  DESYNC detected at tick %d", l.desync);
+    if (l.rejected) printf("  %lld bad packets", l.rejected);
+    printf("\n");
+    same &= k.game.hash()==peers[0].game.hash();
+  }
+  printf(same ? "all peers agree\n" : "peers differ\n");
+  return 0;
+}
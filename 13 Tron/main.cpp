@@ -1,49 +1,82 @@
 #include <SFML/Graphics.hpp>
 #include <time.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include "Bots.hpp"
+#include "Lockstep.hpp"
 using namespace sf;
 
 const int W=600;
 const int H=480;
 int speed = 4;
-bool field[W][H]={0};
+Match game;
 
 struct player
-{ int x,y,dir;
-  Color color;
-  player(Color c)
+{ Color color;
+  size_t drawn;   //trail segments already in the texture for good
+  int keys;       //1 arrows, 2 WASD, 0 a bot drives, -1 another machine
+  Bot bot;
+
+  // new trail as quads, 6 px wide like the old dots; the last segment is
+  // sent again every frame since it may still grow
+  void addTrail(VertexArray &v, const std::vector<Segment> &trail)
   {
-    x=rand() % W;
-    y=rand() % H;
-    color=c;
-    dir=rand() % 4;
-  }
-  void tick()
-  {
-    if (dir==0) y+=1;
-    if (dir==1) x-=1;
-    if (dir==2) x+=1;
-    if (dir==3) y-=1;
-
-	if (x>=W) x=0;  if (x<0) x=W-1;
-    if (y>=H) y=0;  if (y<0) y=H-1;
+    for(size_t i=drawn;i<trail.size();i++)
+    {
+      const Segment &s=trail[i];
+      float x0=std::min(s.x0,s.x1), y0=std::min(s.y0,s.y1);
+      float x1=std::max(s.x0,s.x1)+6, y1=std::max(s.y0,s.y1)+6;
+      v.append(Vertex(Vector2f(x0,y0),color)); v.append(Vertex(Vector2f(x1,y0),color));
+      v.append(Vertex(Vector2f(x1,y1),color)); v.append(Vertex(Vector2f(x0,y1),color));
+    }
+    if (!trail.empty()) drawn=trail.size()-1;
   }
 
   Vector3f getColor()
   {return Vector3f(color.r,color.g,color.b);}
 };
 
-int main()
+// tron [players=2] [humans=2]: players past the humans are Voronoi bots
+// tron net <me> <host:port> <host:port> ...: a player per machine over UDP;
+//   every machine gets the same addresses in the same order, `me` is its
+//   own place in the list
+int main(int argc,char*argv[])
 {
-	srand(time(0));
+	bool online = argc>4 && std::string(argv[1])=="net";
+	int me = online ? atoi(argv[2]) : 0;
+	std::vector<std::string> addresses;
+	if (online) addresses.assign(argv+3, argv+argc);
+
+	int players = online ? addresses.size() : argc>1 ? atoi(argv[1]) : 2;
+	int humans  = argc>2 ? atoi(argv[2]) : 2;
+	players=std::max(2,std::min(players,8));
+	humans=std::max(0,std::min(humans,std::min(players,2)));
+	game.reset(W,H,players,time(0));   //online dealt again from what the machines agree on
+
+	Udp udp;
+	Lockstep lock(game, udp, online ? me : 0, 16, Lockstep::hashOf(addresses), time(0));
+	if (online)
+	{
+		std::string &a=addresses[std::max(0,std::min(me,players-1))];
+		if (me<0 || me>=players || !udp.open(atoi(a.c_str()+a.rfind(':')+1), addresses))
+			{printf("can't play as %d on %s\n", me, a.c_str()); return 1;}
+	}
 
-    RenderWindow window(VideoMode(W, H), "The Tron Game!");
+    RenderWindow window(VideoMode(W, H), online ? "The Tron Game! - waiting for the others" : "The Tron Game!");
     window.setFramerateLimit(60);
 
 	Texture texture;
 	texture.loadFromFile("background.jpg");
 	Sprite sBackground(texture);
 
-    player p1(Color::Red), p2(Color::Green); 
+	Color colors[8]={Color::Red, Color::Green, Color::Blue, Color::Yellow, Color::Magenta, Color::Cyan, Color::White, Color(255,128,0)};
+	std::vector<player> p(players);
+	for(int i=0;i<players;i++)
+	{
+		p[i].color=colors[i]; p[i].drawn=0;
+		p[i].keys = online ? (i==me ? 1 : -1) : i<humans ? i+1 : 0;
+		p[i].bot = Bot(Bot::Voronoi, 24, game.seed+i);
+	}
 
 	Sprite sprite;
 	RenderTexture t;
@@ -52,7 +85,7 @@ int main()
 	sprite.setTexture(t.getTexture());
     t.clear();  t.draw(sBackground);
 
-	bool Game=1;
+	VertexArray quads(Quads);
 
     while (window.isOpen())
     {
@@ -63,32 +96,54 @@ int main()
                 window.close();
 		}
 
-		if (Keyboard::isKeyPressed(Keyboard::Left)) if (p1.dir!=2) p1.dir=1;
-	    if (Keyboard::isKeyPressed(Keyboard::Right)) if (p1.dir!=1)  p1.dir=2;
-	    if (Keyboard::isKeyPressed(Keyboard::Up)) if (p1.dir!=0) p1.dir=3;
-		if (Keyboard::isKeyPressed(Keyboard::Down)) if (p1.dir!=3) p1.dir=0;
+		int dir[8];
+		for(int i=0;i<players;i++)
+		{
+			dir[i]=-1;
+			if (p[i].keys==1)
+			{
+				if (Keyboard::isKeyPressed(Keyboard::Left)) dir[i]=1;
+				if (Keyboard::isKeyPressed(Keyboard::Right)) dir[i]=2;
+				if (Keyboard::isKeyPressed(Keyboard::Up)) dir[i]=3;
+				if (Keyboard::isKeyPressed(Keyboard::Down)) dir[i]=0;
+			}
+			if (p[i].keys==2)
+			{
+				if (Keyboard::isKeyPressed(Keyboard::A)) dir[i]=1;
+				if (Keyboard::isKeyPressed(Keyboard::D)) dir[i]=2;
+				if (Keyboard::isKeyPressed(Keyboard::W)) dir[i]=3;
+				if (Keyboard::isKeyPressed(Keyboard::S)) dir[i]=0;
+			}
+			if (!online) game.steer(i,dir[i]);
+		}
 
-		if (Keyboard::isKeyPressed(Keyboard::A)) if (p2.dir!=2) p2.dir=1;
-	    if (Keyboard::isKeyPressed(Keyboard::D)) if (p2.dir!=1)  p2.dir=2;
-	    if (Keyboard::isKeyPressed(Keyboard::W)) if (p2.dir!=0) p2.dir=3;
-		if (Keyboard::isKeyPressed(Keyboard::S)) if (p2.dir!=3) p2.dir=0;
+		// online the game moves as the others' keys come in, and keeps
+		// talking after the end so nobody is left waiting for our input
+		if (online)
+		{
+			for(int k=0;k<speed && lock.canInput();k++) lock.input(dir[me]);
+			lock.send();
+			lock.poll();
+			while(lock.ready()) lock.advance();
+			if (!lock.connected) continue;
+			if (!lock.tick()) window.setTitle("The Tron Game!");
+			if (lock.desync>=0) window.setTitle("The Tron Game! - out of step, detected at tick "+std::to_string(lock.desync));
+		}
 
-		if (!Game)	continue;
+		if (game.over())	continue;
 
-		for(int i=0;i<speed;i++)
+		for(int k=0;k<speed && !game.over() && !online;k++)
 		{
-			p1.tick(); p2.tick();
-			if (field[p1.x][p1.y]==1) Game=0; 
-			if (field[p2.x][p2.y]==1) Game=0;
-			field[p1.x][p1.y]=1; 
-			field[p2.x][p2.y]=1;
-	
-			CircleShape c(3);
-			c.setPosition(p1.x,p1.y); c.setFillColor(p1.color);	t.draw(c);
-			c.setPosition(p2.x,p2.y); c.setFillColor(p2.color);	t.draw(c);
-			t.display();	
+			for(int i=0;i<players;i++)
+				if (!p[i].keys && game.alive[i]) game.steer(i, p[i].bot.choose(game,i));
+			game.step();
 		}
 
+		quads.clear();
+		for(int i=0;i<players;i++) p[i].addTrail(quads, game.riders[i].trail);
+		t.draw(quads);
+		t.display();
+
 	   ////// draw  ///////
 		window.clear();
 		window.draw(sprite);
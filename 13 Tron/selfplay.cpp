@@ -0,0 +1,85 @@
+// Bot against bot, no window, for ranking bot versions:
+//   g++ -std=c++11 -O2 -pthread selfplay.cpp -o selfplay
+//   ./selfplay [matches=2000] [bots=voronoi,flood] [size=64x48] [seed=1] [threads=all]
+// Bots are "flood" or "voronoi", with a search depth after a colon
+// ("voronoi:16", 64 when left out); one rider each. Match i is played from
+// seed+i with the line-up turned round i places, so every bot starts from
+// every seat as often. The results only depend on the seed, not on the
+// threads: the digest line is the same for any thread count.
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include "Bots.hpp"
+#include "../common/Jobs.hpp"
+
+double now() {return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();}
+
+struct Result {int winner, ticks;};   //winner: line-up index, -1 for a draw
+
+Result play(std::vector<Bot> &bots, int W, int H, uint64_t seed, int turn)
+{
+  int P=bots.size();
+  Match m(W, H, P, uint32_t(splitmix(seed)));
+  for(int s=0;s<P;s++) bots[(s+turn)%P].seed=uint32_t(splitmix(seed*P+s))|1;
+  while(!m.over())
+  {
+    for(int s=0;s<P;s++) if (m.alive[s]) m.steer(s, bots[(s+turn)%P].choose(m,s));
+    m.step();
+  }
+  Result r={m.winner()<0 ? -1 : (m.winner()+turn)%P, m.ticks};
+  return r;
+}
+
+int main(int argc, char *argv[])
+{
+  int matches = argc>1 ? atoi(argv[1]) : 2000;
+  std::string list = argc>2 ? argv[2] : "voronoi,flood";
+  int W=64, H=48;
+  if (argc>3) sscanf(argv[3], "%dx%d", &W, &H);
+  uint64_t seed = argc>4 ? strtoull(argv[4],0,10) : 1;
+  int threads = argc>5 ? atoi(argv[5]) : std::thread::hardware_concurrency();
+
+  std::vector<Bot> lineup;
+  for(size_t a=0;a<=list.size();)
+  {
+    size_t e=list.find(',', a);
+    if (e==std::string::npos) e=list.size();
+    Bot b;
+    if (!Bot::parse(list.substr(a,e-a), b)) {printf("bad bot '%s'\n", list.substr(a,e-a).c_str()); return 1;}
+    lineup.push_back(b);
+    a=e+1;
+  }
+  int P=lineup.size();
+  if (P<2 || W<8 || H<8) {printf("need two bots and at least 8x8\n"); return 1;}
+
+  Jobs jobs(threads);
+  std::vector<Result> results(matches);
+  double t0=now();
+  jobs.run(matches, 4, [&](int a,int e)
+   {
+     std::vector<Bot> bots=lineup;   //own search buffers per thread
+     for(int i=a;i<e;i++) results[i]=play(bots, W, H, seed+i, i%P);
+   });
+  double t=now()-t0;
+
+  std::vector<int> wins(P,0);
+  int draws=0;
+  long long ticks=0;
+  uint64_t digest=0;
+  for(int i=0;i<matches;i++)
+  {
+    if (results[i].winner<0) draws++; else wins[results[i].winner]++;
+    ticks+=results[i].ticks;
+    digest=splitmix(digest ^ uint64_t(results[i].winner+1)<<32 ^ results[i].ticks);
+  }
+
+  printf("%d matches on %dx%d, %d threads: %.2f s, %.1f matches/s, %.0f ticks/match\n",
+         matches, W, H, jobs.size(), t, matches/t, double(ticks)/matches);
+  for(int p=0;p<P;p++)
+    printf("  %-14s %6d wins  %5.1f%%\n", lineup[p].name().c_str(), wins[p], 100.0*wins[p]/matches);
+  printf("  %-14s %6d        %5.1f%%\n", "draws", draws, 100.0*draws/matches);
+  printf("digest %016llx\n", (unsigned long long)digest);
+  return 0;
+}
@@ -0,0 +1,99 @@
+#ifndef BOARD_H
+#define BOARD_H
+
+#include <string>
+#include <vector>
+#include "Position.hpp"
+
+// The game as the window shows it: the position, which of the 32 piece
+// sprites stands on each square and the other way round, and the moves
+// played so far with what each one changed, so taking one back costs the
+// same as playing it.
+struct Board
+{
+  Position pos;
+  int sprite[64];   //sprite on each square, -1 none
+  int square[32];   //where each sprite stands, -1 once taken
+  int piece[32];    //what each sprite shows, color*6+piece (a pawn may become a queen)
+
+  struct Played
+  {
+    Move m;
+    Undo u;
+    int mover, taken, rook;   //sprites; taken and rook -1 if none
+  };
+  std::vector<Played> played;
+
+  Board() {reset();}
+
+  // the start position, sprites numbered from a8 to h1
+  void reset()
+  {
+    pos.set(startFen);
+    played.clear();
+    int k=0;
+    for(int i=0;i<64;i++) sprite[i]=-1;
+    for(int r=7;r>=0;r--)
+     for(int c=0;c<8;c++)
+     {
+       int sq=r*8+c;
+       if (pos.board[sq]==NoPiece) continue;
+       sprite[sq]=k; square[k]=sq; piece[k]=pos.board[sq];
+       k++;
+     }
+    for(;k<32;k++) square[k]=-1;
+  }
+
+  static int capturedOn(Move m, int side) {return moveKind(m)==EnPassant ? moveTo(m)+(side==White ? -8 : 8) : moveTo(m);}
+  static int rookFrom(Move m) {return moveTo(m)>moveFrom(m) ? moveTo(m)+1 : moveTo(m)-2;}
+  static int rookTo(Move m) {return moveTo(m)>moveFrom(m) ? moveTo(m)-1 : moveTo(m)+1;}
+
+  void place(int s, int sq) {if (square[s]>=0 && sprite[square[s]]==s) sprite[square[s]]=-1; square[s]=sq; if (sq>=0) sprite[sq]=s;}
+
+  // plays `s` ("e2e4", "e7e8q") if it is legal
+  Move play(const std::string &s)
+  {
+    Move m=pos.parse(s);
+    if (!m) return 0;
+    Played p;
+    p.m=m;
+    int from=moveFrom(m), to=moveTo(m);
+    p.mover=sprite[from];
+    p.taken=sprite[capturedOn(m,pos.side)];
+    p.rook = moveKind(m)==Castling ? sprite[rookFrom(m)] : -1;
+
+    if (p.taken>=0) place(p.taken,-1);
+    place(p.mover,to);
+    if (moveKind(m)==Promotion) piece[p.mover]=pos.side*6+movePromo(m);
+    if (p.rook>=0) place(p.rook,rookTo(m));
+
+    pos.make(m,p.u);
+    played.push_back(p);
+    return m;
+  }
+
+  // takes the last move back; false if there is none
+  bool undo()
+  {
+    if (played.empty()) return false;
+    Played p=played.back();
+    played.pop_back();
+    pos.unmake(p.m,p.u);
+    int from=moveFrom(p.m);
+    place(p.mover,from);
+    piece[p.mover]=pos.board[from];
+    if (p.rook>=0) place(p.rook,rookFrom(p.m));
+    if (p.taken>=0) place(p.taken,capturedOn(p.m,pos.side));
+    return true;
+  }
+
+  // the moves so far, as an engine wants them: "e2e4 e7e5 "
+  std::string moves() const
+  {
+    std::string s;
+    for(const Played &p: played) s+=Position::uci(p.m)+" ";
+    return s;
+  }
+};
+
+#endif
@@ -1,74 +1,272 @@
 #ifndef CONNECTOR_H
 #define CONNECTOR_H
 
-#include <windows.h>
 #include <stdio.h>
-#include <iostream>
+#include <stdlib.h>
 #include <string>
+#include <sstream>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
 
-STARTUPINFO sti = {0};
-SECURITY_ATTRIBUTES sats = {0};
-PROCESS_INFORMATION pi = {0};
-HANDLE pipin_w, pipin_r, pipout_w, pipout_r;
-BYTE buffer[2048];
-DWORD writ, excode, read, available;
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#include <signal.h>
+#include <sys/wait.h>
+#endif
 
+// What the engine said about the search so far (its latest "info" lines)
+struct EngineInfo
+{
+  int depth, seldepth;
+  int score;          //centipawns, for the side to move
+  int mate;           //mate in this many moves, negative if getting mated, 0 none
+  long long nodes, nps, time;
+  std::string pv;
 
-void ConnectToEngine(char* path)
+  EngineInfo() : depth(0), seldepth(0), score(0), mate(0), nodes(0), nps(0), time(0) {}
+};
+
+// Whatever plays the other side: a UCI engine, or the built-in one
+struct Opponent
+{
+  virtual ~Opponent() {}
+  virtual void go(const std::string &moves, int movetime, int depth=0) = 0;
+  virtual void stop() = 0;
+  virtual void cancel() = 0;
+  virtual bool thinking() const = 0;
+  virtual bool poll(std::string &move) = 0;
+  virtual EngineInfo status() = 0;
+};
+
+// A UCI engine in a child process. A thread reads its output line by line
+// as it comes and keeps what it says in `info` and `best`; nothing here
+// waits for the engine, so the game can ask every frame:
+//
+//   engine.start("stockfish");
+//   engine.go(position, 500);            //think half a second
+//   ...
+//   if (engine.poll(move)) ...           //"e7e5" once it has answered
+//
+// UCI has no way to add a move to the engine's position, so go() sends the
+// whole move list each time; it's only a few hundred bytes.
+struct Engine : Opponent
 {
-   pipin_w = pipin_r = pipout_w = pipout_r = NULL;
-   sats.nLength = sizeof(sats);
-   sats.bInheritHandle = TRUE;
-   sats.lpSecurityDescriptor = NULL;
-
-   CreatePipe(&pipout_r, &pipout_w, &sats, 0);
-   CreatePipe(&pipin_r, &pipin_w, &sats, 0);
-         
-   sti.dwFlags = STARTF_USESHOWWINDOW | STARTF_USESTDHANDLES;
-   sti.wShowWindow = SW_HIDE;
-   sti.hStdInput = pipin_r;
-   sti.hStdOutput = pipout_w;
-   sti.hStdError = pipout_w;
-
-   CreateProcess(NULL, path, NULL, NULL, TRUE,0, NULL, NULL, &sti, &pi);
-}
-
-
-std::string getNextMove(std::string position)
-{     
-	std::string str;
-	position = "position startpos moves "+position+"\ngo\n";	
-
-	WriteFile(pipin_w, position.c_str(), position.length(),&writ, NULL);
-    Sleep(500);
-        
-    PeekNamedPipe(pipout_r, buffer,sizeof(buffer), &read, &available, NULL);   
-    do
-    {   
-        ZeroMemory(buffer, sizeof(buffer));
-		if(!ReadFile(pipout_r, buffer, sizeof(buffer), &read, NULL) || !read) break; 
-        buffer[read] = 0;	
-		str+=(char*)buffer;
+  std::thread reader;
+  std::mutex m;
+  EngineInfo info;
+  std::string best;         //last answer not yet collected by poll()
+  bool answered;
+  int drop;                 //answers of cancelled searches still to come
+  std::atomic<bool> searching, alive;
+
+#ifdef _WIN32
+  HANDLE toEngine, fromEngine;
+  PROCESS_INFORMATION pi;
+#else
+  int toEngine, fromEngine;
+  pid_t pid;
+#endif
+
+  Engine() : answered(false), drop(0), searching(false), alive(false)
+  {
+#ifdef _WIN32
+    toEngine=fromEngine=NULL; ZeroMemory(&pi, sizeof(pi));
+#else
+    toEngine=fromEngine=-1; pid=-1;
+#endif
+  }
+  ~Engine() {close();}
+
+  bool start(const char *path)
+  {
+    close();
+#ifdef _WIN32
+    SECURITY_ATTRIBUTES sats = {0};
+    sats.nLength = sizeof(sats);
+    sats.bInheritHandle = TRUE;
+    HANDLE inR, inW, outR, outW;
+    if (!CreatePipe(&outR, &outW, &sats, 0)) return false;
+    if (!CreatePipe(&inR, &inW, &sats, 0)) {CloseHandle(outR); CloseHandle(outW); return false;}
+    SetHandleInformation(outR, HANDLE_FLAG_INHERIT, 0);   //our ends stay ours
+    SetHandleInformation(inW, HANDLE_FLAG_INHERIT, 0);
+
+    STARTUPINFOA sti = {0};
+    sti.cb = sizeof(sti);
+    sti.dwFlags = STARTF_USESHOWWINDOW | STARTF_USESTDHANDLES;
+    sti.wShowWindow = SW_HIDE;
+    sti.hStdInput = inR;
+    sti.hStdOutput = outW;
+    sti.hStdError = outW;
+    std::string cmd = path;
+    bool ok = CreateProcessA(NULL, &cmd[0], NULL, NULL, TRUE, 0, NULL, NULL, &sti, &pi);
+    CloseHandle(inR); CloseHandle(outW);
+    if (!ok) {CloseHandle(inW); CloseHandle(outR); return false;}
+    toEngine=inW; fromEngine=outR;
+#else
+    int in[2], out[2];
+    if (pipe(in)) return false;
+    if (pipe(out)) {::close(in[0]); ::close(in[1]); return false;}
+    pid = fork();
+    if (pid==0)
+    {
+      dup2(in[0], 0); dup2(out[1], 1); dup2(out[1], 2);
+      ::close(in[0]); ::close(in[1]); ::close(out[0]); ::close(out[1]);
+      execlp(path, path, (char*)0);
+      _exit(127);
+    }
+    ::close(in[0]); ::close(out[1]);
+    if (pid<0) {::close(in[1]); ::close(out[0]); return false;}
+    signal(SIGPIPE, SIG_IGN);   //a dead engine mustn't take the game with it
+    toEngine=in[1]; fromEngine=out[0];
+#endif
+    alive=true;
+    reader = std::thread(&Engine::readLoop, this);
+    send("uci");
+    send("isready");
+    return true;
+  }
+
+  void send(const std::string &line)
+  {
+    std::string s = line+"\n";
+#ifdef _WIN32
+    DWORD writ;
+    if (toEngine) WriteFile(toEngine, s.c_str(), s.length(), &writ, NULL);
+#else
+    if (toEngine>=0 && write(toEngine, s.c_str(), s.length())<0) alive=false;
+#endif
+  }
+
+  // Searches `moves` from the start ("e2e4 e7e5 ..."), for `movetime` ms
+  // or to `depth`, whichever is given. A search still running is cancelled.
+  void go(const std::string &moves, int movetime, int depth=0)
+  {
+    cancel();
+    {
+      std::lock_guard<std::mutex> lock(m);
+      info = EngineInfo();
     }
-    while(read >= sizeof(buffer));
+    send("position startpos moves "+moves);
+    std::ostringstream s;
+    s << "go";
+    if (movetime>0) s << " movetime " << movetime;
+    if (depth>0) s << " depth " << depth;
+    if (movetime<=0 && depth<=0) s << " infinite";
+    searching=true;
+    send(s.str());
+  }
 
-	int n = str.find("bestmove");  
-	if (n!=-1) return str.substr(n+9,4);
-			 
-    return "error";
-}
+  // move now: the engine answers with the best it has
+  void stop() {if (searching) send("stop");}
 
+  // stop and forget: that answer won't come out of poll()
+  void cancel()
+  {
+    std::lock_guard<std::mutex> lock(m);
+    answered=false;
+    if (!searching) return;
+    drop++; searching=false;
+    send("stop");
+  }
 
-void CloseConnection()
-{
-	WriteFile(pipin_w, "quit\n", 5,&writ, NULL);
-    if(pipin_w != NULL) CloseHandle(pipin_w);
-    if(pipin_r != NULL) CloseHandle(pipin_r);
-    if(pipout_w != NULL) CloseHandle(pipout_w);
-    if(pipout_r != NULL) CloseHandle(pipout_r);
-    if(pi.hProcess != NULL) CloseHandle(pi.hProcess);
-    if(pi.hThread != NULL) CloseHandle(pi.hThread);
-}
+  bool thinking() const {return searching;}
+
+  // true once, with the move, when the engine has answered
+  bool poll(std::string &move)
+  {
+    std::lock_guard<std::mutex> lock(m);
+    if (!answered) return false;
+    answered=false;
+    move=best;
+    return true;
+  }
+
+  EngineInfo status() {std::lock_guard<std::mutex> lock(m); return info;}
+
+  void readLoop()
+  {
+    std::string line;
+    char buf[4096];
+    for(;;)
+    {
+#ifdef _WIN32
+      DWORD n=0;
+      if (!ReadFile(fromEngine, buf, sizeof(buf), &n, NULL) || !n) break;
+#else
+      ssize_t n=read(fromEngine, buf, sizeof(buf));
+      if (n<=0) break;
+#endif
+      for(int i=0;i<int(n);i++)
+      {
+        if (buf[i]=='\n') {parse(line); line.clear();}
+        else if (buf[i]!='\r') line+=buf[i];
+      }
+    }
+    alive=false; searching=false;   //gone: no answer is coming
+  }
+
+  void parse(const std::string &line)
+  {
+    std::istringstream in(line);
+    std::string word;
+    in >> word;
+    std::lock_guard<std::mutex> lock(m);
+    if (word=="bestmove")
+    {
+      std::string move;
+      in >> move;
+      if (drop>0) {drop--; return;}
+      best=move; answered=true; searching=false;
+    }
+    else if (word=="info")
+      while(in >> word)
+      {
+        if (word=="depth") in >> info.depth;
+        else if (word=="seldepth") in >> info.seldepth;
+        else if (word=="nodes") in >> info.nodes;
+        else if (word=="nps") in >> info.nps;
+        else if (word=="time") in >> info.time;
+        else if (word=="score")
+        {
+          std::string kind; int v=0;
+          in >> kind >> v;
+          if (kind=="cp") {info.score=v; info.mate=0;}
+          if (kind=="mate") info.mate=v;
+        }
+        else if (word=="pv")
+        {
+          std::getline(in, info.pv);
+          if (!info.pv.empty() && info.pv[0]==' ') info.pv.erase(0,1);
+        }
+      }
+  }
 
+  void close()
+  {
+    if (!reader.joinable()) return;
+    send("quit");
+#ifdef _WIN32
+    CloseHandle(toEngine); toEngine=NULL;
+    if (WaitForSingleObject(pi.hProcess, 1000)!=WAIT_OBJECT_0) TerminateProcess(pi.hProcess, 1);
+    reader.join();
+    CloseHandle(fromEngine); fromEngine=NULL;
+    CloseHandle(pi.hProcess); CloseHandle(pi.hThread);
+    ZeroMemory(&pi, sizeof(pi));
+#else
+    ::close(toEngine); toEngine=-1;
+    int status;
+    for(int i=0;i<100 && waitpid(pid, &status, WNOHANG)==0;i++)
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    if (waitpid(pid, &status, WNOHANG)==0) {kill(pid, SIGKILL); waitpid(pid, &status, 0);}
+    reader.join();
+    ::close(fromEngine); fromEngine=-1; pid=-1;
+#endif
+    searching=false; answered=false; drop=0;
+  }
+};
 
-#endif CONNECTOR_H
\ No newline at end of file
+#endif
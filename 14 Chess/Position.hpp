@@ -0,0 +1,515 @@
+#ifndef POSITION_H
+#define POSITION_H
+
+#include <cstdint>
+#include <string>
+#include <sstream>
+#include <vector>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// Chess rules on bitboards: one bit per square, a1=0, b1=1 .. h8=63.
+// Sliding attacks come from magic bitboard tables: the blockers on a
+// piece's lines, times a magic number, give the index of the attack set.
+typedef uint64_t Bitboard;
+
+enum {White, Black};
+enum {Pawn, Knight, Bishop, Rook, Queen, King};
+const int NoPiece = 12;   //board[] holds color*6+piece, or this
+
+inline Bitboard bit(int sq) {return Bitboard(1)<<sq;}
+
+inline int lsb(Bitboard b)
+{
+#ifdef _MSC_VER
+  unsigned long i; _BitScanForward64(&i, b); return i;
+#else
+  return __builtin_ctzll(b);
+#endif
+}
+
+inline int popLsb(Bitboard &b) {int s=lsb(b); b&=b-1; return s;}
+
+inline int popcount(Bitboard b)
+{
+#ifdef _MSC_VER
+  return int(__popcnt64(b));
+#else
+  return __builtin_popcountll(b);
+#endif
+}
+
+// Move: from | to<<6 | kind<<12 | promotion<<14 (0 knight .. 3 queen).
+// 0 is no move (a1a1 never is one).
+typedef uint16_t Move;
+enum {Normal, Promotion, EnPassant, Castling};
+
+inline Move makeMove(int from, int to, int kind=Normal, int promo=Knight) {return Move(from | to<<6 | kind<<12 | (promo-Knight)<<14);}
+inline int moveFrom(Move m) {return m&63;}
+inline int moveTo(Move m) {return m>>6&63;}
+inline int moveKind(Move m) {return m>>12&3;}
+inline int movePromo(Move m) {return Knight+(m>>14);}
+
+inline uint64_t splitmix(uint64_t &s)
+{
+  uint64_t x = (s += 0x9e3779b97f4a7c15ull);
+  x = (x^(x>>30))*0xbf58476d1ce4e5b9ull;
+  x = (x^(x>>27))*0x94d049bb133111ebull;
+  return x^(x>>31);
+}
+
+struct Magic
+{
+  Bitboard mask, magic;
+  Bitboard *attacks;
+  int shift;
+  Bitboard get(Bitboard occ) const {return attacks[((occ&mask)*magic)>>shift];}
+};
+
+// Attack tables and hash keys, built once on first use. The magics are
+// searched for then, from fixed seeds, so they always come out the same;
+// it takes about 50 ms.
+struct Tables
+{
+  Bitboard knight[64], king[64], pawn[2][64];
+  Bitboard between[64][64];   //squares strictly between two on a line, else 0
+  Bitboard line[64][64];      //the whole line through both, else 0
+  Magic rook[64], bishop[64];
+  std::vector<Bitboard> rookTable, bishopTable;
+  uint64_t piece[12][64], castle[16], epFile[8], side;
+
+  static Bitboard slide(int sq, Bitboard occ, const int (*dirs)[2])
+  {
+    Bitboard a=0;
+    for(int d=0;d<4;d++)
+      for(int f=sq%8+dirs[d][0], r=sq/8+dirs[d][1]; f>=0 && f<8 && r>=0 && r<8; f+=dirs[d][0], r+=dirs[d][1])
+      {
+        a|=bit(r*8+f);
+        if (occ&bit(r*8+f)) break;
+      }
+    return a;
+  }
+
+  static uint64_t rand64(uint64_t &s) {s^=s>>12; s^=s<<25; s^=s>>27; return s*2685821657736338717ull;}
+
+  void initMagics(Magic *magics, std::vector<Bitboard> &table, const int (*dirs)[2])
+  {
+    static const uint64_t seeds[8]={728, 10316, 55013, 32803, 12281, 15100, 16645, 255};   //per rank, known to find magics fast
+    size_t total=0;
+    Bitboard masks[64];
+    for(int sq=0;sq<64;sq++)
+    {
+      Bitboard edges = ((0xffull|0xffull<<56) & ~(0xffull<<(sq/8*8))) | ((0x0101010101010101ull|0x8080808080808080ull) & ~(0x0101010101010101ull<<(sq%8)));
+      masks[sq]=slide(sq,0,dirs) & ~edges;
+      total+=size_t(1)<<popcount(masks[sq]);
+    }
+    table.assign(total, 0);
+
+    Bitboard occ[4096], ref[4096];
+    int used[4096]={0}, tries=0;
+    Bitboard *p=&table[0];
+    for(int sq=0;sq<64;sq++)
+    {
+      Magic &m=magics[sq];
+      m.mask=masks[sq]; m.shift=64-popcount(m.mask); m.attacks=p;
+      int n=0;
+      Bitboard b=0;
+      do {occ[n]=b; ref[n]=slide(sq,b,dirs); n++; b=(b-m.mask)&m.mask;} while(b);   //every subset of the mask
+
+      uint64_t seed=seeds[sq/8];
+      for(;;)
+      {
+        m.magic = rand64(seed) & rand64(seed) & rand64(seed);   //few bits set work best
+        if (popcount((m.mask*m.magic)>>56)<6) continue;
+        tries++;
+        int i=0;
+        for(;i<n;i++)
+        {
+          size_t k=((occ[i]&m.mask)*m.magic)>>m.shift;
+          if (used[k]!=tries) {used[k]=tries; p[k]=ref[i];}
+          else if (p[k]!=ref[i]) break;
+        }
+        if (i==n) break;
+      }
+      p+=n;
+    }
+  }
+
+  Tables()
+  {
+    static const int rookDirs[4][2]={{1,0},{-1,0},{0,1},{0,-1}};
+    static const int bishopDirs[4][2]={{1,1},{1,-1},{-1,1},{-1,-1}};
+    static const int knightSteps[8][2]={{1,2},{2,1},{2,-1},{1,-2},{-1,-2},{-2,-1},{-2,1},{-1,2}};
+    for(int sq=0;sq<64;sq++)
+    {
+      int f=sq%8, r=sq/8;
+      knight[sq]=king[sq]=pawn[White][sq]=pawn[Black][sq]=0;
+      for(int i=0;i<8;i++)
+      {
+        int x=f+knightSteps[i][0], y=r+knightSteps[i][1];
+        if (x>=0 && x<8 && y>=0 && y<8) knight[sq]|=bit(y*8+x);
+      }
+      for(int dx=-1;dx<=1;dx++)
+       for(int dy=-1;dy<=1;dy++)
+        if ((dx||dy) && f+dx>=0 && f+dx<8 && r+dy>=0 && r+dy<8) king[sq]|=bit((r+dy)*8+f+dx);
+      for(int dx=-1;dx<=1;dx+=2)
+        if (f+dx>=0 && f+dx<8)
+        {
+          if (r<7) pawn[White][sq]|=bit((r+1)*8+f+dx);
+          if (r>0) pawn[Black][sq]|=bit((r-1)*8+f+dx);
+        }
+    }
+
+    initMagics(rook, rookTable, rookDirs);
+    initMagics(bishop, bishopTable, bishopDirs);
+
+    for(int a=0;a<64;a++)
+      for(int b=0;b<64;b++)
+      {
+        between[a][b]=line[a][b]=0;
+        if (a==b) continue;
+        for(int k=0;k<2;k++)
+        {
+          const int (*dirs)[2] = k ? bishopDirs : rookDirs;
+          if (slide(a,0,dirs) & bit(b))
+          {
+            between[a][b] = slide(a,bit(b),dirs) & slide(b,bit(a),dirs);
+            line[a][b] = (slide(a,0,dirs) & slide(b,0,dirs)) | bit(a) | bit(b);
+          }
+        }
+      }
+
+    uint64_t z=1070372;
+    for(int p=0;p<12;p++) for(int sq=0;sq<64;sq++) piece[p][sq]=splitmix(z);
+    for(int i=0;i<16;i++) castle[i] = i ? splitmix(z) : 0;
+    for(int i=0;i<8;i++) epFile[i]=splitmix(z);
+    side=splitmix(z);
+  }
+};
+
+inline const Tables &tables() {static Tables t; return t;}
+
+inline Bitboard rookAttacks(int sq, Bitboard occ) {return tables().rook[sq].get(occ);}
+inline Bitboard bishopAttacks(int sq, Bitboard occ) {return tables().bishop[sq].get(occ);}
+
+const char startFen[] = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+// what make() needs to take a move back
+struct Undo
+{
+  int captured, castle, ep, rule50;
+  uint64_t key;
+};
+
+struct Position
+{
+  Bitboard byType[6], byColor[2], all;
+  int board[64];
+  int side, castle, ep, rule50, ply;   //castle: 1 white short, 2 white long, 4 black short, 8 black long; ep -1 or the square
+  uint64_t key;
+
+  Position() {set(startFen);}
+
+  Bitboard pieces(int c, int p) const {return byType[p] & byColor[c];}
+  int king(int c) const {return lsb(pieces(c,King));}
+
+  void put(int pc, int sq)
+  {
+    board[sq]=pc; byType[pc%6]|=bit(sq); byColor[pc/6]|=bit(sq); all|=bit(sq);
+    key^=tables().piece[pc][sq];
+  }
+
+  void take(int sq)
+  {
+    int pc=board[sq];
+    board[sq]=NoPiece; byType[pc%6]^=bit(sq); byColor[pc/6]^=bit(sq); all^=bit(sq);
+    key^=tables().piece[pc][sq];
+  }
+
+  // false, and the start position, when `fen` makes no sense
+  bool set(const std::string &fen)
+  {
+    for(int i=0;i<6;i++) byType[i]=0;
+    byColor[0]=byColor[1]=all=0;
+    for(int i=0;i<64;i++) board[i]=NoPiece;
+    key=0;
+
+    std::istringstream in(fen);
+    std::string placing, color="w", rights="-", eps="-";
+    int fullmove=1;
+    rule50=0;
+    in >> placing >> color >> rights >> eps >> rule50 >> fullmove;
+
+    int sq=56;
+    for(char c: placing)
+    {
+      if (c=='/') sq-=16;
+      else if (c>='1' && c<='8') sq+=c-'0';
+      else
+      {
+        size_t p=std::string("PNBRQKpnbrqk").find(c);
+        if (p==std::string::npos || sq<0 || sq>63) return set(startFen), false;
+        put(p, sq++);
+      }
+    }
+    if (popcount(pieces(White,King))!=1 || popcount(pieces(Black,King))!=1) return set(startFen), false;
+
+    side = color=="b" ? Black : White;
+    castle=0;
+    for(char c: rights)
+      if (c=='K') castle|=1; else if (c=='Q') castle|=2; else if (c=='k') castle|=4; else if (c=='q') castle|=8;
+    ep = eps.size()==2 ? (eps[0]-'a') + 8*(eps[1]-'1') : -1;
+    if (ep<0 || ep>63 || !(tables().pawn[side^1][ep] & pieces(side,Pawn))) ep=-1;   //only kept when it can be taken
+    ply = 2*(fullmove-1) + side;
+    key ^= tables().castle[castle] ^ (ep>=0 ? tables().epFile[ep%8] : 0) ^ (side ? tables().side : 0);
+    return true;
+  }
+
+  std::string fen() const
+  {
+    std::string s;
+    for(int r=7;r>=0;r--)
+    {
+      int gap=0;
+      for(int f=0;f<8;f++)
+      {
+        int pc=board[r*8+f];
+        if (pc==NoPiece) {gap++; continue;}
+        if (gap) s+=char('0'+gap);
+        gap=0;
+        s+="PNBRQKpnbrqk"[pc];
+      }
+      if (gap) s+=char('0'+gap);
+      if (r) s+='/';
+    }
+    s += side ? " b " : " w ";
+    if (castle&1) s+='K';
+    if (castle&2) s+='Q';
+    if (castle&4) s+='k';
+    if (castle&8) s+='q';
+    if (!castle) s+='-';
+    s += ep<0 ? std::string(" -") : std::string(" ") + char('a'+ep%8) + char('1'+ep/8);
+    return s + " " + std::to_string(rule50) + " " + std::to_string(ply/2+1);
+  }
+
+  // the key from scratch, to check the one kept up to date
+  uint64_t computeKey() const
+  {
+    const Tables &t=tables();
+    uint64_t k=t.castle[castle] ^ (ep>=0 ? t.epFile[ep%8] : 0) ^ (side ? t.side : 0);
+    for(int sq=0;sq<64;sq++) if (board[sq]!=NoPiece) k^=t.piece[board[sq]][sq];
+    return k;
+  }
+
+  Bitboard attackers(int sq, int by, Bitboard occ) const
+  {
+    const Tables &t=tables();
+    return ((t.pawn[by^1][sq] & byType[Pawn]) | (t.knight[sq] & byType[Knight]) | (t.king[sq] & byType[King])
+          | (bishopAttacks(sq,occ) & (byType[Bishop]|byType[Queen])) | (rookAttacks(sq,occ) & (byType[Rook]|byType[Queen])))
+          & byColor[by];
+  }
+
+  bool inCheck() const {return attackers(king(side), side^1, all)!=0;}
+
+  // own pieces that are all that stands between an enemy slider and our king
+  Bitboard pinned() const
+  {
+    const Tables &t=tables();
+    int k=king(side), them=side^1;
+    Bitboard pins=0;
+    Bitboard snipers = ((rookAttacks(k,0) & (byType[Rook]|byType[Queen])) | (bishopAttacks(k,0) & (byType[Bishop]|byType[Queen]))) & byColor[them];
+    while(snipers)
+    {
+      Bitboard b=t.between[k][popLsb(snipers)] & all;
+      if (b && !(b&(b-1))) pins|=b & byColor[side];
+    }
+    return pins;
+  }
+
+  // moves that follow the moves of the pieces, the king may still be left in check
+  Move *pseudo(Move *list) const
+  {
+    const Tables &t=tables();
+    int us=side, them=side^1;
+    Bitboard own=byColor[us], enemy=byColor[them], empty=~all;
+    int up = us==White ? 8 : -8;
+    Bitboard last = us==White ? 0xffull<<56 : 0xffull;
+    Bitboard third = us==White ? 0xffull<<16 : 0xffull<<40;
+
+    Bitboard pawns=pieces(us,Pawn);
+    Bitboard one = (us==White ? pawns<<8 : pawns>>8) & empty;
+    Bitboard two = (us==White ? (one&third)<<8 : (one&third)>>8) & empty;
+    Bitboard left  = (us==White ? (pawns & ~0x0101010101010101ull)<<7 : (pawns & ~0x0101010101010101ull)>>9) & enemy;
+    Bitboard right = (us==White ? (pawns & ~0x8080808080808080ull)<<9 : (pawns & ~0x8080808080808080ull)>>7) & enemy;
+    int leftStep = us==White ? 7 : -9, rightStep = us==White ? 9 : -7;
+
+    for(Bitboard b=one;b;)
+    {
+      int to=popLsb(b);
+      if (bit(to)&last) for(int p=Queen;p>=Knight;p--) *list++=makeMove(to-up,to,Promotion,p);
+      else *list++=makeMove(to-up,to);
+    }
+    for(Bitboard b=two;b;) {int to=popLsb(b); *list++=makeMove(to-2*up,to);}
+    for(int k=0;k<2;k++)
+      for(Bitboard b = k ? right : left;b;)
+      {
+        int to=popLsb(b), from=to-(k ? rightStep : leftStep);
+        if (bit(to)&last) for(int p=Queen;p>=Knight;p--) *list++=makeMove(from,to,Promotion,p);
+        else *list++=makeMove(from,to);
+      }
+    if (ep>=0)
+      for(Bitboard b=t.pawn[them][ep] & pawns;b;) *list++=makeMove(popLsb(b),ep,EnPassant);
+
+    for(int p=Knight;p<=King;p++)
+      for(Bitboard b=pieces(us,p);b;)
+      {
+        int from=popLsb(b);
+        Bitboard to = p==Knight ? t.knight[from] : p==Bishop ? bishopAttacks(from,all) : p==Rook ? rookAttacks(from,all)
+                    : p==Queen ? bishopAttacks(from,all)|rookAttacks(from,all) : t.king[from];
+        for(to&=~own;to;) *list++=makeMove(from,popLsb(to));
+      }
+
+    // castling: the rook unmoved, the squares between empty, the king
+    // not in check and not passing through one (where it lands is left
+    // to legal())
+    int base = us==White ? 0 : 56;
+    if ((castle>>(2*us))&1 && !(all & (bit(base+5)|bit(base+6))) && !attackers(base+4,them,all) && !attackers(base+5,them,all))
+      *list++=makeMove(base+4,base+6,Castling);
+    if ((castle>>(2*us))&2 && !(all & (bit(base+1)|bit(base+2)|bit(base+3))) && !attackers(base+4,them,all) && !attackers(base+3,them,all))
+      *list++=makeMove(base+4,base+2,Castling);
+    return list;
+  }
+
+  // does the move leave our king safe; `pins` from pinned(), `check` from inCheck()
+  bool legal(Move m, Bitboard pins, bool check) const
+  {
+    const Tables &t=tables();
+    int from=moveFrom(m), to=moveTo(m), us=side, them=side^1, k=king(us);
+    if (from==k) return !attackers(to, them, all^bit(from));
+    if (!check && moveKind(m)!=EnPassant) return !(pins&bit(from)) || (t.line[k][from]&bit(to));
+
+    // in check, or en passant (it takes two pieces off a line at once):
+    // look at the board as it would be
+    int gone = moveKind(m)==EnPassant ? to+(us==White ? -8 : 8) : to;
+    Bitboard occ=(all^bit(from)^bit(gone))|bit(to);
+    Bitboard theirs=byColor[them]&~bit(gone);
+    return !(((t.pawn[us][k] & byType[Pawn]) | (t.knight[k] & byType[Knight])
+            | (bishopAttacks(k,occ) & (byType[Bishop]|byType[Queen])) | (rookAttacks(k,occ) & (byType[Rook]|byType[Queen]))) & theirs);
+  }
+
+  // every legal move into `list` (room for 256), returns the end
+  Move *generate(Move *list) const
+  {
+    Move *end=pseudo(list), *out=list;
+    Bitboard pins=pinned();
+    bool check=inCheck();
+    for(Move *p=list;p<end;p++) if (legal(*p,pins,check)) *out++=*p;
+    return out;
+  }
+
+  // castling rights a move from or to each square leaves
+  static int castleKeep(int sq)
+  {
+    switch(sq) {case 0: return ~2; case 4: return ~3; case 7: return ~1; case 56: return ~8; case 60: return ~12; case 63: return ~4;}
+    return ~0;
+  }
+
+  void make(Move m, Undo &u)
+  {
+    const Tables &t=tables();
+    int from=moveFrom(m), to=moveTo(m), kind=moveKind(m), us=side, them=side^1;
+    u.captured=NoPiece; u.castle=castle; u.ep=ep; u.rule50=rule50; u.key=key;
+
+    int pc=board[from];
+    rule50++;
+    if (kind==EnPassant) {int c=to+(us==White ? -8 : 8); u.captured=board[c]; take(c);}
+    else if (board[to]!=NoPiece) {u.captured=board[to]; take(to);}
+    if (u.captured!=NoPiece || pc%6==Pawn) rule50=0;
+
+    take(from);
+    put(kind==Promotion ? us*6+movePromo(m) : pc, to);
+    if (kind==Castling)
+    {
+      int rf = to>from ? to+1 : to-2, rt = to>from ? to-1 : to+1;
+      int rook=board[rf];
+      take(rf); put(rook, rt);
+    }
+
+    key^=t.castle[castle]; castle&=castleKeep(from)&castleKeep(to); key^=t.castle[castle];
+    if (ep>=0) key^=t.epFile[ep%8];
+    ep=-1;
+    if (pc%6==Pawn && (to-from==16 || from-to==16) && (t.pawn[us][(from+to)/2] & pieces(them,Pawn)))
+    {
+      ep=(from+to)/2;
+      key^=t.epFile[ep%8];
+    }
+    side=them; key^=t.side;
+    ply++;
+  }
+
+  void unmake(Move m, const Undo &u)
+  {
+    int from=moveFrom(m), to=moveTo(m), kind=moveKind(m);
+    side^=1; ply--;
+    int us=side;
+    if (kind==Castling)
+    {
+      int rf = to>from ? to+1 : to-2, rt = to>from ? to-1 : to+1;
+      int rook=board[rt];
+      take(rt); put(rook, rf);
+    }
+    int pc = kind==Promotion ? us*6+Pawn : board[to];
+    take(to);
+    put(pc, from);
+    if (u.captured!=NoPiece) put(u.captured, kind==EnPassant ? to+(us==White ? -8 : 8) : to);
+    castle=u.castle; ep=u.ep; rule50=u.rule50; key=u.key;
+  }
+
+  // a pass: for searches that let the other side move twice
+  void makeNull(Undo &u)
+  {
+    const Tables &t=tables();
+    u.captured=NoPiece; u.castle=castle; u.ep=ep; u.rule50=rule50; u.key=key;
+    if (ep>=0) key^=t.epFile[ep%8];
+    ep=-1; side^=1; key^=t.side; rule50++; ply++;
+  }
+
+  void unmakeNull(const Undo &u) {side^=1; ply--; ep=u.ep; rule50=u.rule50; key=u.key;}
+
+  static std::string square(int sq) {return std::string(1,'a'+sq%8) + char('1'+sq/8);}
+
+  static std::string uci(Move m)
+  {
+    if (!m) return "0000";
+    std::string s=square(moveFrom(m))+square(moveTo(m));
+    if (moveKind(m)==Promotion) s+="nbrq"[movePromo(m)-Knight];
+    return s;
+  }
+
+  // the legal move written as `s` ("e2e4", "e7e8q", "e1g1"), 0 if none
+  Move parse(const std::string &s) const
+  {
+    Move list[256], *end=generate(list);
+    for(Move *p=list;p<end;p++) if (uci(*p)==s) return *p;
+    return 0;
+  }
+};
+
+// leaf nodes `depth` moves on, the count every move generator is checked by
+inline uint64_t perft(Position &pos, int depth)
+{
+  Move list[256], *end=pos.generate(list);
+  if (depth<=1) return depth==1 ? end-list : 1;
+  uint64_t n=0;
+  Undo u;
+  for(Move *p=list;p<end;p++)
+  {
+    pos.make(*p,u);
+    n+=perft(pos,depth-1);
+    pos.unmake(*p,u);
+  }
+  return n;
+}
+
+#endif
@@ -0,0 +1,566 @@
+#ifndef SEARCH_H
+#define SEARCH_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "Position.hpp"
+#include "Connector.hpp"
+
+// The game's own opponent: alpha-beta on Position.hpp, so no engine
+// executable is needed.
+//
+//  - iterative deepening, principal variation search (null windows for
+//    all but the first move, re-searched when one does better), check
+//    extension, null move pruning and late move reductions
+//  - quiescence search of captures at the leaves
+//  - moves tried hash move first, then captures by most valuable victim,
+//    then the two killers of the ply, then quiet moves by history
+//  - Lazy SMP: every thread searches the same root, sharing only the
+//    transposition table; half the helpers go one ply deeper so they
+//    fill it ahead of the main thread
+
+const int Infinite = 32001, Mate = 32000, MaxPly = 100;
+
+const int pieceValue[6] = {100, 320, 330, 500, 900, 0};
+
+// where each piece likes to stand, as white sees the board (a8 top left);
+// the last is the king once the pieces are off
+const int8_t squareBonus[7][64] = {
+  {  0,  0,  0,  0,  0,  0,  0,  0,
+    50, 50, 50, 50, 50, 50, 50, 50,
+    10, 10, 20, 30, 30, 20, 10, 10,
+     5,  5, 10, 25, 25, 10,  5,  5,
+     0,  0,  0, 20, 20,  0,  0,  0,
+     5, -5,-10,  0,  0,-10, -5,  5,
+     5, 10, 10,-20,-20, 10, 10,  5,
+     0,  0,  0,  0,  0,  0,  0,  0},
+  {-50,-40,-30,-30,-30,-30,-40,-50,
+   -40,-20,  0,  0,  0,  0,-20,-40,
+   -30,  0, 10, 15, 15, 10,  0,-30,
+   -30,  5, 15, 20, 20, 15,  5,-30,
+   -30,  0, 15, 20, 20, 15,  0,-30,
+   -30,  5, 10, 15, 15, 10,  5,-30,
+   -40,-20,  0,  5,  5,  0,-20,-40,
+   -50,-40,-30,-30,-30,-30,-40,-50},
+  {-20,-10,-10,-10,-10,-10,-10,-20,
+   -10,  0,  0,  0,  0,  0,  0,-10,
+   -10,  0,  5, 10, 10,  5,  0,-10,
+   -10,  5,  5, 10, 10,  5,  5,-10,
+   -10,  0, 10, 10, 10, 10,  0,-10,
+   -10, 10, 10, 10, 10, 10, 10,-10,
+   -10,  5,  0,  0,  0,  0,  5,-10,
+   -20,-10,-10,-10,-10,-10,-10,-20},
+  {  0,  0,  0,  0,  0,  0,  0,  0,
+     5, 10, 10, 10, 10, 10, 10,  5,
+    -5,  0,  0,  0,  0,  0,  0, -5,
+    -5,  0,  0,  0,  0,  0,  0, -5,
+    -5,  0,  0,  0,  0,  0,  0, -5,
+    -5,  0,  0,  0,  0,  0,  0, -5,
+    -5,  0,  0,  0,  0,  0,  0, -5,
+     0,  0,  0,  5,  5,  0,  0,  0},
+  {-20,-10,-10, -5, -5,-10,-10,-20,
+   -10,  0,  0,  0,  0,  0,  0,-10,
+   -10,  0,  5,  5,  5,  5,  0,-10,
+    -5,  0,  5,  5,  5,  5,  0, -5,
+     0,  0,  5,  5,  5,  5,  0, -5,
+   -10,  5,  5,  5,  5,  5,  0,-10,
+   -10,  0,  5,  0,  0,  0,  0,-10,
+   -20,-10,-10, -5, -5,-10,-10,-20},
+  {-30,-40,-40,-50,-50,-40,-40,-30,
+   -30,-40,-40,-50,-50,-40,-40,-30,
+   -30,-40,-40,-50,-50,-40,-40,-30,
+   -30,-40,-40,-50,-50,-40,-40,-30,
+   -20,-30,-30,-40,-40,-30,-30,-20,
+   -10,-20,-20,-20,-20,-20,-20,-10,
+    20, 20,  0,  0,  0,  0, 20, 20,
+    20, 30, 10,  0,  0, 10, 30, 20},
+  {-50,-40,-30,-20,-20,-30,-40,-50,
+   -30,-20,-10,  0,  0,-10,-20,-30,
+   -30,-10, 20, 30, 30, 20,-10,-30,
+   -30,-10, 30, 40, 40, 30,-10,-30,
+   -30,-10, 30, 40, 40, 30,-10,-30,
+   -30,-10, 20, 30, 30, 20,-10,-30,
+   -30,-30,  0,  0,  0,  0,-30,-30,
+   -50,-30,-30,-30,-30,-30,-30,-50}};
+
+// material and squares, for the side to move; the king slides from its
+// middlegame squares to its endgame ones as the pieces come off
+inline int evaluate(const Position &pos)
+{
+  int score[2]={0,0}, phase=0;   //phase: 24 with all the pieces on, 0 with none
+  for(int c=0;c<2;c++)
+  {
+    for(int p=Pawn;p<King;p++)
+    {
+      Bitboard b=pos.pieces(c,p);
+      phase += popcount(b) * (p==Knight || p==Bishop ? 1 : p==Rook ? 2 : p==Queen ? 4 : 0);
+      while(b)
+      {
+        int sq=popLsb(b);
+        score[c] += pieceValue[p] + squareBonus[p][c==White ? sq^56 : sq];
+      }
+    }
+  }
+  phase=std::min(phase,24);
+  for(int c=0;c<2;c++)
+  {
+    int k=pos.king(c), v = c==White ? k^56 : k;
+    score[c] += (squareBonus[King][v]*phase + squareBonus[6][v]*(24-phase))/24;
+  }
+  int s=score[White]-score[Black];
+  return pos.side==White ? s : -s;
+}
+
+// Transposition table shared by all the threads, without a lock. An entry
+// is two words, data and key^data, each written in one go. A thread that
+// reads while another is half way through a write gets a pair that doesn't
+// XOR back to its key, and takes it as a miss (Hyatt's lockless hashing).
+struct TTable
+{
+  enum {Upper=1, Lower=2, Exact=3};
+
+  struct Entry {std::atomic<uint64_t> check, data;};
+  std::unique_ptr<Entry[]> entries;
+  size_t mask;
+  int age;   //searches so far: older entries give way first
+
+  TTable(int mb=64) : mask(0), age(0) {resize(mb);}
+
+  void resize(int mb)
+  {
+    size_t n=1;
+    while(2*n*sizeof(Entry) <= size_t(mb)<<20) n*=2;
+    entries.reset(new Entry[n]);
+    mask=n-1;
+    clear();
+  }
+
+  void clear()
+  {
+    for(size_t i=0;i<=mask;i++) {entries[i].check=0; entries[i].data=0;}
+    age=0;
+  }
+
+  // data: move 16 | score 16 | depth 8 | bound 2 | age 6
+  bool probe(uint64_t key, Move &move, int &score, int &depth, int &bound) const
+  {
+    const Entry &e=entries[key&mask];
+    uint64_t d=e.data.load(std::memory_order_relaxed), c=e.check.load(std::memory_order_relaxed);
+    if ((c^d)!=key || !d) return false;
+    move=Move(d); score=int16_t(d>>16); depth=int(d>>32&255); bound=int(d>>40&3);
+    return true;
+  }
+
+  void store(uint64_t key, Move move, int score, int depth, int bound)
+  {
+    Entry &e=entries[key&mask];
+    uint64_t old=e.data.load(std::memory_order_relaxed);
+    bool same = (e.check.load(std::memory_order_relaxed)^old)==key;
+    // a deeper entry from this search stays, unless this one is exact
+    if (old && int(old>>42)==(age&63) && bound!=Exact && depth+2<int(old>>32&255)) return;
+    if (same && !move) move=Move(old);
+    uint64_t d = uint64_t(move) | uint64_t(uint16_t(score))<<16 | uint64_t(depth&255)<<32 | uint64_t(bound)<<40 | uint64_t(age&63)<<42;
+    e.data.store(d, std::memory_order_relaxed);
+    e.check.store(key^d, std::memory_order_relaxed);
+  }
+};
+
+inline double searchClock() {return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();}
+
+// what the threads of one search share
+struct Shared
+{
+  TTable tt;
+  std::atomic<bool> halt;
+  double deadline;   //searchClock() time to stop at
+  std::mutex m;
+  EngineInfo info;   //after each depth the main thread finishes
+
+  Shared() : halt(false), deadline(0) {}
+};
+
+// mate scores are stored as distances from the node, not from the root
+inline int toTT(int v, int ply) {return v>Mate-MaxPly ? v+ply : v<-Mate+MaxPly ? v-ply : v;}
+inline int fromTT(int v, int ply) {return v>Mate-MaxPly ? v-ply : v<-Mate+MaxPly ? v+ply : v;}
+
+// One search thread, with its own board and move ordering tables
+struct Worker
+{
+  Shared *shared;
+  int id;
+  Position pos;
+  std::vector<uint64_t> keys;   //every position so far, for repetitions
+  Move killers[MaxPly][2];
+  int history[2][64][64];
+  long long nodes;
+  std::atomic<long long> counted;   //nodes, as other threads may read them
+  int seldepth;
+  Move best;                        //of the last depth finished
+  int score, depth;
+  double start;                     //searchClock() when the search began
+
+  Worker() : shared(0), id(0), nodes(0), counted(0), seldepth(0), best(0), score(0), depth(0), start(0) {}
+
+  void reset(Shared &s, int i, const Position &p, const std::vector<uint64_t> &k)
+  {
+    shared=&s; id=i; pos=p; keys=k;
+    if (keys.empty() || keys.back()!=pos.key) keys.push_back(pos.key);
+    for(int j=0;j<MaxPly;j++) killers[j][0]=killers[j][1]=0;
+    for(int c=0;c<2;c++) for(int a=0;a<64;a++) for(int b=0;b<64;b++) history[c][a][b]=0;
+    nodes=0; counted=0; seldepth=0; best=0; score=0; depth=0;
+  }
+
+  bool repeated() const
+  {
+    int n=int(keys.size())-1;
+    for(int i=n-4;i>=0 && i>=n-pos.rule50;i-=2)
+      if (keys[i]==keys[n]) return true;
+    return false;
+  }
+
+  // counts a node; every 1024 the main thread looks at the clock
+  bool stopped()
+  {
+    if ((++nodes&1023)==0)
+    {
+      counted.store(nodes, std::memory_order_relaxed);
+      if (id==0 && searchClock()>shared->deadline) shared->halt=true;
+    }
+    return shared->halt.load(std::memory_order_relaxed);
+  }
+
+  bool capture(Move m) const {return pos.board[moveTo(m)]!=NoPiece || moveKind(m)==EnPassant;}
+
+  // ordering keys, highest first
+  void rate(const Move *list, int n, int *rating, Move hashMove, int ply) const
+  {
+    for(int i=0;i<n;i++)
+    {
+      Move m=list[i];
+      int from=moveFrom(m), to=moveTo(m);
+      if (m==hashMove) rating[i]=1<<30;
+      else if (capture(m)) rating[i] = (1<<28) + 8*(moveKind(m)==EnPassant ? Pawn : pos.board[to]%6) - pos.board[from]%6;
+      else if (moveKind(m)==Promotion) rating[i] = movePromo(m)==Queen ? (1<<28) : -(1<<20);
+      else if (m==killers[ply][0]) rating[i]=(1<<27)+1;
+      else if (m==killers[ply][1]) rating[i]=1<<27;
+      else rating[i]=history[pos.side][from][to];
+    }
+  }
+
+  // the best of the moves left goes next
+  static Move pick(Move *list, int *rating, int i, int n)
+  {
+    int b=i;
+    for(int j=i+1;j<n;j++) if (rating[j]>rating[b]) b=j;
+    std::swap(list[i],list[b]); std::swap(rating[i],rating[b]);
+    return list[i];
+  }
+
+  int quiesce(int alpha, int beta, int ply)
+  {
+    if (stopped()) return 0;
+    seldepth=std::max(seldepth,ply);
+    if (ply>=MaxPly-1) return evaluate(pos);
+
+    bool check=pos.inCheck();
+    int bestScore=-Infinite;
+    if (!check)   //standing pat: no need to capture
+    {
+      bestScore=evaluate(pos);
+      if (bestScore>=beta) return bestScore;
+      alpha=std::max(alpha,bestScore);
+    }
+
+    Move list[256];
+    int rating[256], n=int(pos.generate(list)-list);
+    if (check && !n) return -Mate+ply;
+    if (!check)   //captures and queenings only
+    {
+      int k=0;
+      for(int i=0;i<n;i++)
+        if (capture(list[i]) || (moveKind(list[i])==Promotion && movePromo(list[i])==Queen)) list[k++]=list[i];
+      n=k;
+    }
+    rate(list, n, rating, 0, ply);
+    for(int i=0;i<n;i++)
+    {
+      Move m=pick(list, rating, i, n);
+      Undo u;
+      pos.make(m,u);
+      int v=-quiesce(-beta, -alpha, ply+1);
+      pos.unmake(m,u);
+      if (shared->halt) return 0;
+      if (v>bestScore)
+      {
+        bestScore=v;
+        if (v>alpha) {alpha=v; if (v>=beta) break;}
+      }
+    }
+    return bestScore;
+  }
+
+  int search(int alpha, int beta, int depth, int ply, bool pv, bool nullOk)
+  {
+    if (ply && (pos.rule50>=100 || repeated())) return 0;
+    if (depth<=0) return quiesce(alpha, beta, ply);
+    if (stopped()) return 0;
+    if (ply>=MaxPly-1) return evaluate(pos);
+
+    const int alpha0=alpha;
+    Move hashMove=0;
+    int ttScore, ttDepth, ttBound;
+    if (shared->tt.probe(pos.key, hashMove, ttScore, ttDepth, ttBound))
+    {
+      ttScore=fromTT(ttScore, ply);
+      if (!pv && ttDepth>=depth &&
+          (ttBound==TTable::Exact || (ttBound==TTable::Lower && ttScore>=beta) || (ttBound==TTable::Upper && ttScore<=alpha)))
+        return ttScore;
+    }
+
+    bool check=pos.inCheck();
+    if (check) depth++;
+    int side=pos.side;
+    bool pieces = (pos.byColor[side] & ~(pos.pieces(side,Pawn)|pos.pieces(side,King)))!=0;
+
+    if (!pv && !check && beta<Mate-MaxPly)
+    {
+      int eval=evaluate(pos);
+      if (depth<=3 && eval-120*depth>=beta) return eval;   //too far ahead to come back
+      if (nullOk && depth>=3 && eval>=beta && pieces)        //still ahead after passing?
+      {
+        Undo u;
+        pos.makeNull(u); keys.push_back(pos.key);
+        int v=-search(-beta, -beta+1, depth-3-depth/6, ply+1, false, false);
+        keys.pop_back(); pos.unmakeNull(u);
+        if (shared->halt) return 0;
+        if (v>=beta) return v>Mate-MaxPly ? beta : v;
+      }
+    }
+
+    Move list[256];
+    int rating[256], n=int(pos.generate(list)-list);
+    if (!n) return check ? -Mate+ply : 0;
+    rate(list, n, rating, hashMove, ply);
+
+    int bestScore=-Infinite;
+    Move bestMove=0;
+    for(int i=0;i<n;i++)
+    {
+      Move m=pick(list, rating, i, n);
+      bool quiet = !capture(m) && moveKind(m)!=Promotion;
+      Undo u;
+      pos.make(m,u); keys.push_back(pos.key);
+      int v;
+      if (!i) v=-search(-beta, -alpha, depth-1, ply+1, pv, true);
+      else
+      {
+        int r = depth>=3 && i>=3 && quiet && !check && !pos.inCheck() ? 1 + (i>=8) + depth/8 : 0;
+        v=-search(-alpha-1, -alpha, depth-1-r, ply+1, false, true);
+        if (v>alpha && r) v=-search(-alpha-1, -alpha, depth-1, ply+1, false, true);
+        if (v>alpha && v<beta) v=-search(-beta, -alpha, depth-1, ply+1, true, true);
+      }
+      keys.pop_back(); pos.unmake(m,u);
+      if (shared->halt) return 0;
+
+      if (v>bestScore)
+      {
+        bestScore=v; bestMove=m;
+        if (!ply) best=m;
+        if (v>alpha) alpha=v;
+        if (v>=beta)
+        {
+          if (quiet)
+          {
+            if (killers[ply][0]!=m) {killers[ply][1]=killers[ply][0]; killers[ply][0]=m;}
+            int &h=history[side][moveFrom(m)][moveTo(m)];
+            h+=depth*depth;
+            if (h>1<<20)   //keep them well below the killers
+              for(int a=0;a<64;a++) for(int b=0;b<64;b++) history[side][a][b]/=2;
+          }
+          break;
+        }
+      }
+    }
+
+    int bound = bestScore>=beta ? TTable::Lower : bestScore>alpha0 ? TTable::Exact : TTable::Upper;
+    shared->tt.store(pos.key, bestMove, toTT(bestScore, ply), depth, bound);
+    return bestScore;
+  }
+
+  // the hash moves from here: the line the search expects
+  std::string line(int length)
+  {
+    std::string s;
+    Position p=pos;
+    for(int i=0;i<length;i++)
+    {
+      Move m=0, list[256], *end=p.generate(list);
+      int v, d, b;
+      if (!shared->tt.probe(p.key, m, v, d, b) || std::find(list, end, m)==end) break;
+      if (i) s+=' ';
+      s+=Position::uci(m);
+      Undo u;
+      p.make(m,u);
+    }
+    return s;
+  }
+
+  // iterative deepening up to maxDepth or until halted; helpers with an
+  // odd id stay one ply ahead of the main thread
+  void think(int maxDepth, const std::vector<Worker*> &all)
+  {
+    Move list[256];
+    if (pos.generate(list)==list) return;
+    best=list[0];
+    Move chosen=list[0];
+    for(int d=1+(id&1); d<=maxDepth; d++)
+    {
+      int v=search(-Infinite, Infinite, d, 0, true, true);
+      if (shared->halt && (depth || id)) break;   //cut short: only the main thread's first depth counts
+      chosen=best; score=v; depth=d;
+      if (id) continue;
+
+      long long total=0;
+      for(Worker *w: all) total+=w->id ? w->counted.load(std::memory_order_relaxed) : nodes;
+      double t=searchClock();
+      std::lock_guard<std::mutex> lock(shared->m);
+      EngineInfo &i=shared->info;
+      long long ms=(long long)(1000*(t-start));
+      i.depth=d; i.seldepth=seldepth; i.nodes=total; i.time=ms;
+      i.nps = total*1000/std::max(1LL,ms);
+      i.score=v; i.mate=0;
+      if (v>Mate-MaxPly) i.mate=(Mate-v+1)/2;
+      if (v<-Mate+MaxPly) i.mate=-(Mate+v)/2;
+      i.pv=line(d);
+      if (i.mate && d>=2*std::abs(i.mate)+2) break;   //nothing faster to find
+    }
+    best=chosen;
+    counted=nodes;
+  }
+};
+
+// The built-in engine. It plays through the same calls as a UCI engine in
+// Connector.hpp, so the game can use either; run() is the same search
+// without a thread of its own, for the benchmark.
+struct Search : Opponent
+{
+  Shared shared;
+  int threads;
+  std::vector<std::unique_ptr<Worker> > workers;
+  std::thread runner;
+  std::string best;
+  bool answered;
+  std::atomic<bool> searching;
+
+  Search(int threads=0, int mb=64) : threads(threads), answered(false), searching(false)
+  {
+    if (threads<=0) this->threads=std::max(1u, std::thread::hardware_concurrency());
+    shared.tt.resize(mb);
+  }
+  ~Search() {cancel();}
+
+  // blocks until the best move for `pos` is found; `keys` are the
+  // positions before it, for repetitions
+  Move run(const Position &pos, const std::vector<uint64_t> &keys, int movetime, int depth=0)
+  {
+    shared.halt=false;
+    return think(pos, keys, movetime, depth);
+  }
+
+  Move think(const Position &pos, const std::vector<uint64_t> &keys, int movetime, int depth)
+  {
+    double t0=searchClock();
+    shared.deadline = movetime>0 ? t0+movetime/1000.0 : 1e300;
+    shared.tt.age++;
+    {
+      std::lock_guard<std::mutex> lock(shared.m);
+      shared.info=EngineInfo();
+    }
+    while(int(workers.size())<threads) workers.emplace_back(new Worker);
+    workers.resize(threads);
+    std::vector<Worker*> all;
+    for(int i=0;i<threads;i++)
+    {
+      workers[i]->reset(shared, i, pos, keys);
+      workers[i]->start=t0;
+      all.push_back(workers[i].get());
+    }
+    int maxDepth = depth>0 ? std::min(depth, MaxPly-1) : MaxPly-1;
+
+    std::vector<std::thread> helpers;
+    for(int i=1;i<threads;i++) helpers.emplace_back(&Worker::think, workers[i].get(), maxDepth, std::ref(all));
+    workers[0]->think(maxDepth, all);
+    shared.halt=true;
+    for(auto &h: helpers) h.join();
+
+    // the deepest finished search wins, the main thread's on a tie
+    Worker *w=workers[0].get();
+    for(Worker *o: all) if (o->depth>w->depth && o->best) w=o;
+    return w->best;
+  }
+
+  long long nodes() const
+  {
+    long long n=0;
+    for(auto &w: workers) n+=w->counted;
+    return n;
+  }
+
+  void go(const std::string &moves, int movetime, int depth=0)
+  {
+    cancel();
+    Position pos;
+    std::vector<uint64_t> keys(1, pos.key);
+    std::istringstream in(moves);
+    std::string s;
+    while(in >> s)
+    {
+      Move m=pos.parse(s);
+      if (!m) break;
+      Undo u;
+      pos.make(m,u);
+      keys.push_back(pos.key);
+    }
+    shared.halt=false;
+    searching=true;
+    runner = std::thread([this, pos, keys, movetime, depth]
+    {
+      Move m=think(pos, keys, movetime, depth);
+      std::lock_guard<std::mutex> lock(shared.m);
+      if (!searching) return;   //cancelled
+      best=Position::uci(m); answered=true; searching=false;
+    });
+  }
+
+  void stop() {shared.halt=true;}
+
+  void cancel()
+  {
+    {
+      std::lock_guard<std::mutex> lock(shared.m);
+      searching=false; answered=false;
+    }
+    shared.halt=true;
+    if (runner.joinable()) runner.join();
+  }
+
+  bool thinking() const {return searching;}
+
+  bool poll(std::string &move)
+  {
+    std::lock_guard<std::mutex> lock(shared.m);
+    if (!answered) return false;
+    answered=false;
+    move=best;
+    return true;
+  }
+
+  EngineInfo status() {std::lock_guard<std::mutex> lock(shared.m); return shared.info;}
+};
+
+#endif
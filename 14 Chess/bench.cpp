@@ -0,0 +1,56 @@
+// Speed of the built-in engine on fixed positions, and how it scales:
+//   g++ -std=c++11 -O2 -pthread bench.cpp -o bench
+//   ./bench [depth=10] [threads=all cores] [hash MB=64]
+// Each position is searched to the same depth with 1, 2, 4 .. threads,
+// starting from an empty table every time. Reported per thread count:
+// nodes, nodes/s, the time to reach the depth and how much faster that is
+// than one thread. With one thread the node count is the same every run,
+// so it also tells whether a change altered the search.
+#include <cstdio>
+#include <cstdlib>
+#include "Search.hpp"
+
+const char *fens[] = {
+  startFen,
+  "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+  "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+  "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+  "r1bqkb1r/pppp1ppp/2n2n2/4p2Q/2B1P3/8/PPPP1PPP/RNB1K1NR w KQkq - 4 4",
+  "2rq1rk1/pp1bppbp/2np1np1/8/3NP3/1BN1BP2/PPPQ2PP/2KR3R b - - 6 12",
+  "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+  "8/8/4k3/8/2p5/8/B2P2K1/8 w - - 0 1",
+};
+const int count = sizeof(fens)/sizeof(fens[0]);
+
+int main(int argc, char *argv[])
+{
+  int depth = argc>1 ? atoi(argv[1]) : 10;
+  int most  = argc>2 ? atoi(argv[2]) : std::max(1u, std::thread::hardware_concurrency());
+  int mb    = argc>3 ? atoi(argv[3]) : 64;
+  tables();
+
+  double base=0;
+  for(int threads=1;;threads = threads*2>most && threads<most ? most : threads*2)
+  {
+    Search search(threads, mb);
+    long long nodes=0;
+    double time=0;
+    std::string moves;
+    for(int i=0;i<count;i++)
+    {
+      Position pos;
+      pos.set(fens[i]);
+      search.shared.tt.clear();
+      double t0=searchClock();
+      Move m=search.run(pos, std::vector<uint64_t>(), 0, depth);
+      time+=searchClock()-t0;
+      nodes+=search.nodes();
+      moves+=" "+Position::uci(m);
+    }
+    if (threads==1) base=time;
+    printf("%2d threads: %11lld nodes %7.2f s %6.2f Mnps, depth %d %.2fx as fast as 1 thread, moves%s\n",
+           threads, nodes, time, nodes/time/1e6, depth, base/time, moves.c_str());
+    if (threads>=most) break;
+  }
+  return 0;
+}
@@ -0,0 +1,115 @@
+// Stands in for Stockfish when trying the game or the Engine class:
+//   g++ -std=c++11 -O2 -pthread fake_engine.cpp -o fake_engine
+//   ./chess ./fake_engine
+//   ./fake_engine [ms per depth=50] [max depth=20]
+// It speaks enough UCI for Connector.hpp: uci, isready, ucinewgame,
+// position startpos moves ..., go movetime/depth/infinite, stop, quit.
+// While "thinking" it prints an info line per depth. It knows one game
+// (Morphy's Opera game) and answers its next move as long as the moves
+// so far follow it, "0000" (no move) otherwise.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <sstream>
+#include <iostream>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+
+const char *game[] = {"e2e4","e7e5","g1f3","d7d6","d2d4","c8g4","d4e5","g4f3","d1f3","d6e5",
+                      "f1c4","g8f6","f3b3","d8e7","b1c3","c7c6","c1g5","b7b5","c3b5","c6b5",
+                      "c4b5","b8d7","e1c1","a8d8","d1d7","d8d7","h1d1","e7e6","b5d7","f6d7",
+                      "b3b8","d7b8","d1d8"};
+const int gameLength = sizeof(game)/sizeof(game[0]);
+
+std::mutex out;
+std::atomic<bool> halt(false);
+std::thread search;
+int msPerDepth = 50, maxDepth = 20;
+
+void say(const std::string &s)
+{
+  std::lock_guard<std::mutex> lock(out);
+  printf("%s\n", s.c_str());
+  fflush(stdout);
+}
+
+void think(std::string move, int movetime, int depth)
+{
+  auto t0 = std::chrono::steady_clock::now();
+  long long nodes = 0;
+  for(int d=1;;d++)
+  {
+    for(int i=0;i<msPerDepth && !halt;i++) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    long long ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now()-t0).count();
+    if (halt) break;
+    nodes += 1000LL<<std::min(d,20);
+    std::ostringstream s;
+    s << "info depth " << d << " seldepth " << d+2 << " score cp " << 20+d << " nodes " << nodes
+      << " nps " << nodes*1000/std::max(1LL,ms) << " time " << ms << " pv " << move;
+    say(s.str());
+    if (depth>0 && d>=depth) break;
+    if (movetime>0 && ms+msPerDepth>movetime) break;
+    if (d>=maxDepth)   //as deep as it goes; "go infinite" still waits for stop
+    {
+      while(!halt && depth<=0 && movetime<=0) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      break;
+    }
+  }
+  say("bestmove "+move);
+}
+
+void finish()
+{
+  halt=true;
+  if (search.joinable()) search.join();
+  halt=false;
+}
+
+int main(int argc, char *argv[])
+{
+  if (argc>1) msPerDepth = atoi(argv[1]);
+  if (argc>2) maxDepth = atoi(argv[2]);
+
+  std::string line, move="0000";
+  while(std::getline(std::cin, line))
+  {
+    if (!line.empty() && line[line.size()-1]=='\r') line.erase(line.size()-1);
+    std::istringstream in(line);
+    std::string word;
+    in >> word;
+
+    if (word=="uci") say("id name FakeEngine\nid author nobody\nuciok");
+    else if (word=="isready") say("readyok");
+    else if (word=="position")
+    {
+      std::string w;
+      int ply=0;
+      bool follows=true;
+      while(in >> w)
+        if (w!="startpos" && w!="moves")
+        {
+          if (ply>=gameLength || w!=game[ply]) follows=false;
+          ply++;
+        }
+      move = follows && ply<gameLength ? game[ply] : "0000";
+    }
+    else if (word=="go")
+    {
+      finish();
+      int movetime=0, depth=0;
+      std::string w;
+      while(in >> w)
+      {
+        if (w=="movetime") in >> movetime;
+        else if (w=="depth") in >> depth;
+      }
+      search = std::thread(think, move, movetime, depth);
+    }
+    else if (word=="stop") finish();
+    else if (word=="quit") break;
+  }
+  finish();
+  return 0;
+}
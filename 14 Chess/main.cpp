@@ -1,23 +1,17 @@
 #include <SFML/Graphics.hpp>
 #include <time.h>
 #include "Connector.hpp"
+#include "Search.hpp"
+#include "Board.hpp"
 using namespace sf;
 
 int size = 56;
 Vector2f offset(28,28);
 
 Sprite f[32]; //figures
-std::string position="";
-
-int board[8][8] = 
-    {-1,-2,-3,-4,-5,-3,-2,-1,
-	 -6,-6,-6,-6,-6,-6,-6,-6,
-	  0, 0, 0, 0, 0, 0, 0, 0,
-	  0, 0, 0, 0, 0, 0, 0, 0,
-      0, 0, 0, 0, 0, 0, 0, 0,
-	  0, 0, 0, 0, 0, 0, 0, 0,
-	  6, 6, 6, 6, 6, 6, 6, 6,
-	  1, 2, 3, 4, 5, 3, 2, 1};
+Board board;  //the game: position, sprite on each square, moves to take back
+
+const float slideTime = 0.3f; //seconds for a computer move to glide over
 
 std::string toChessNote(Vector2f p)
 {
@@ -27,63 +21,51 @@ std::string toChessNote(Vector2f p)
   return s;
 }
 
-Vector2f toCoord(char a,char b)
+Vector2f toCoord(int sq)
 {
-   int x = int(a) - 97;
-   int y = 7-int(b)+49;
-   return Vector2f(x*size,y*size);
+   return Vector2f(sq%8*size,(7-sq/8)*size);
 }
 
-void move(std::string str)
+// figures.png: rook knight bishop queen king pawn, black above white
+IntRect figure(int pc)
 {
-    Vector2f oldPos = toCoord(str[0],str[1]);
-    Vector2f newPos = toCoord(str[2],str[3]);
-
-	for(int i=0;i<32;i++)
-     if (f[i].getPosition()==newPos) f[i].setPosition(-100,-100);
-		
-    for(int i=0;i<32;i++)
-     if (f[i].getPosition()==oldPos) f[i].setPosition(newPos);
-
-	//castling       //if the king didn't move
-	if (str=="e1g1") if (position.find("e1")==-1) move("h1f1"); 
-	if (str=="e8g8") if (position.find("e8")==-1) move("h8f8");
-	if (str=="e1c1") if (position.find("e1")==-1) move("a1d1");
-	if (str=="e8c8") if (position.find("e8")==-1) move("a8d8");
+   const int column[6] = {5,1,2,0,3,4};
+   return IntRect(size*column[pc%6],size*(pc/6==White),size,size);
 }
 
+// every sprite onto its square, showing what it is now
 void loadPosition()
 {
-	int k=0;
-  	for(int i=0;i<8;i++)
- 	 for(int j=0;j<8;j++)
-     {
-       int n = board[i][j];
-	   if (!n) continue;
-	   int x = abs(n)-1;
-	   int y = n>0?1:0;
-	   f[k].setTextureRect( IntRect(size*x,size*y,size,size) );
-	   f[k].setPosition(size*j,size*i);
-	   k++;
-     }
-
-	 for(int i=0;i<position.length();i+=5)
-	   move(position.substr(i,4));
+	for(int i=0;i<32;i++)
+	 if (board.square[i]>=0)
+	 {
+	   f[i].setTextureRect( figure(board.piece[i]) );
+	   f[i].setPosition( toCoord(board.square[i]) );
+	 }
 }
 
-
-int main()
+// chess [engine]: any UCI engine, the built-in one by default
+int main(int argc,char*argv[])
 {
     RenderWindow window(VideoMode(504, 504), "The Chess! (press SPACE)");
-
-	ConnectToEngine("stockfish.exe");	
+	window.setFramerateLimit(60);
+
+	Search search;
+	Engine uci;
+	Opponent *engine = &search;
+	if (argc>1)
+	{
+	  if (uci.start(argv[1])) engine = &uci;
+	  else printf("can't start %s, playing myself\n", argv[1]);
+	}
+	int shownDepth=0;
 
 	Texture t1,t2;
-    t1.loadFromFile("images/figures.png"); 
+    t1.loadFromFile("images/figures.png");
 	t2.loadFromFile("images/board.png");
 
 	for(int i=0;i<32;i++) f[i].setTexture(t1);
-	Sprite sBoard(t2); 
+	Sprite sBoard(t2);
 
 	loadPosition();
 
@@ -91,11 +73,19 @@ int main()
 	float dx=0, dy=0;
 	Vector2f oldPos,newPos;
 	std::string str;
-	int n=0; 
+	int n=0;
+
+	// the computer's last move, gliding in: its piece (and rook, castling)
+	// go from `from` to their squares; a taken piece stays until it lands
+	int slide[2]={-1,-1}, gone=-1;
+	Vector2f from[2];
+	float t=1;
+	Clock clock;
 
     while (window.isOpen())
     {
    	    Vector2i pos = Mouse::getPosition(window) - Vector2i(offset);
+		float dt = clock.restart().asSeconds();
 
         Event e;
         while (window.pollEvent(e))
@@ -106,58 +96,80 @@ int main()
 			////move back//////
             if (e.type == Event::KeyPressed)
 				if (e.key.code == Keyboard::BackSpace)
-				{ if (position.length()>6) position.erase(position.length()-6,5); loadPosition();}
+				{ engine->cancel(); isMove=false; t=1; if (board.undo()) loadPosition(); }
+
+			////comp move: ask, the answer comes in a later frame//////
+			if (e.type == Event::KeyPressed)
+				if (e.key.code == Keyboard::Space && !engine->thinking())
+				{ engine->go(board.moves(), 500); shownDepth=0; }
 
 			/////drag and drop///////
 			if (e.type == Event::MouseButtonPressed)
-				if (e.key.code == Mouse::Left)
-				  for(int i=0;i<32;i++)
-				  if (f[i].getGlobalBounds().contains(pos.x,pos.y))
+				if (e.key.code == Mouse::Left && pos.x>=0 && pos.y>=0 && pos.x<8*size && pos.y<8*size)
+				{
+				  int i = board.sprite[(7-pos.y/size)*8 + pos.x/size];
+				  if (i>=0)
 					  {
+					   t=1; loadPosition();   //a move still gliding lands at once
 					   isMove=true; n=i;
 					   dx=pos.x - f[i].getPosition().x;
 					   dy=pos.y - f[i].getPosition().y;
 					   oldPos  =  f[i].getPosition();
                       }
+				}
 
              if (e.type == Event::MouseButtonReleased)
-				if (e.key.code == Mouse::Left)
+				if (e.key.code == Mouse::Left && isMove)
 				 {
 				  isMove=false;
 			      Vector2f p = f[n].getPosition() + Vector2f(size/2,size/2);
                   newPos = Vector2f( size*int(p.x/size), size*int(p.y/size) );
 				  str = toChessNote(oldPos)+toChessNote(newPos);
-				  move(str); 
-				  if (oldPos!=newPos) position+=str+" ";
-			      f[n].setPosition(newPos);                   
-			     }                       
+				  int rank = str[3]-'1';
+				  if (board.piece[n]%6==Pawn && (rank==0 || rank==7)) str+='q';   //always a queen
+				  if (oldPos!=newPos && board.play(str)) engine->cancel();
+				  loadPosition();
+			     }
 		}
 
        //comp move
-	   if (Keyboard::isKeyPressed(Keyboard::Space))
+	   if (engine->thinking() && engine->status().depth!=shownDepth)
+	   {
+		 EngineInfo i = engine->status();
+		 char s[64];
+		 if (i.mate) snprintf(s, sizeof(s), "The Chess! thinking: depth %d  mate in %d", i.depth, i.mate);
+		 else snprintf(s, sizeof(s), "The Chess! thinking: depth %d  %+.2f", i.depth, i.score/100.0);
+		 window.setTitle(s);
+		 shownDepth = i.depth;
+	   }
+
+	   if (!isMove && engine->poll(str))   //a piece in hand: the answer can wait
        {
-		 str =  getNextMove(position);
- 		 		 
-         oldPos = toCoord(str[0],str[1]);
-         newPos = toCoord(str[2],str[3]);
-		 
-         for(int i=0;i<32;i++) if (f[i].getPosition()==oldPos) n=i;
-         
-		 /////animation///////
-		 for(int k=0;k<50;k++)
-		  {
-			Vector2f p = newPos - oldPos;
-		    f[n].move(p.x/50, p.y/50); 
-			window.draw(sBoard);
-			for(int i=0;i<32;i++) f[i].move(offset);
-			for(int i=0;i<32;i++) window.draw(f[i]); window.draw(f[n]);
-			for(int i=0;i<32;i++) f[i].move(-offset);
-			window.display();
-		  }
-
-		move(str);  position+=str+" ";
-		f[n].setPosition(newPos); 
-        }
+		 window.setTitle("The Chess! (press SPACE)");
+		 Move m = board.pos.parse(str);
+		 if (m)
+		 {
+		   slide[0] = board.sprite[moveFrom(m)];
+		   slide[1] = moveKind(m)==Castling ? board.sprite[Board::rookFrom(m)] : -1;
+		   gone = board.sprite[Board::capturedOn(m,board.pos.side)];
+		   for(int k=0;k<2;k++) if (slide[k]>=0) from[k] = f[slide[k]].getPosition();
+		   board.play(str);
+		   loadPosition();
+		   n = slide[0]; t = 0;
+		 }
+       }
+
+	   /////animation///////
+	   if (t<1)
+	   {
+		 t = std::min(1.f, t+dt/slideTime);
+		 for(int k=0;k<2;k++)
+		  if (slide[k]>=0)
+		   {
+			 Vector2f to = toCoord(board.square[slide[k]]);
+			 f[slide[k]].setPosition(from[k] + (to-from[k])*t);
+		   }
+	   }
 
 		if (isMove) f[n].setPosition(pos.x-dx,pos.y-dy);
 
@@ -165,12 +177,14 @@ int main()
 	window.clear();
     window.draw(sBoard);
 	for(int i=0;i<32;i++) f[i].move(offset);
-    for(int i=0;i<32;i++) window.draw(f[i]); window.draw(f[n]);
+	if (t<1 && gone>=0) window.draw(f[gone]);
+    for(int i=0;i<32;i++) if (board.square[i]>=0) window.draw(f[i]);
+	if (board.square[n]>=0) window.draw(f[n]);   //the one moving, on top
 	for(int i=0;i<32;i++) f[i].move(-offset);
  	window.display();
 	}
 
-	CloseConnection();
+	engine->cancel(); uci.close();
 
     return 0;
 }
@@ -0,0 +1,97 @@
+// Move generator check and speed, on the usual perft positions:
+//   g++ -std=c++11 -O2 perft.cpp -o perft
+//   ./perft [max depth=5]            the suite, up to that depth
+//   ./perft "<fen>" depth            one position, nodes after each move
+// Every count is compared with the known one. The suite also checks the
+// hash kept by make()/unmake() against one worked out from scratch.
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include "Position.hpp"
+
+double now() {return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();}
+
+struct Test {const char *name, *fen; uint64_t nodes[7];};
+
+const Test tests[] = {
+  {"start",     startFen, {20, 400, 8902, 197281, 4865609, 119060324}},
+  {"kiwipete",  "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", {48, 2039, 97862, 4085603, 193690690}},
+  {"endgame",   "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1", {14, 191, 2812, 43238, 674624, 11030083, 178633661}},
+  {"promotion", "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1", {6, 264, 9467, 422333, 15833292}},
+  {"talkchess", "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8", {44, 1486, 62379, 2103487, 89941194}},
+  {"middle",    "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10", {46, 2079, 89890, 3894594, 164075551}},
+};
+
+// perft that also checks the hash at every node
+uint64_t checked(Position &pos, int depth, bool &ok)
+{
+  if (pos.key!=pos.computeKey()) ok=false;
+  if (!depth) return 1;
+  Move list[256], *end=pos.generate(list);
+  uint64_t n=0;
+  Undo u;
+  for(Move *p=list;p<end;p++)
+  {
+    pos.make(*p,u);
+    n+=checked(pos,depth-1,ok);
+    pos.unmake(*p,u);
+  }
+  return n;
+}
+
+int main(int argc, char *argv[])
+{
+  double t0=now();
+  tables();
+  printf("tables %.1f ms\n", 1000*(now()-t0));
+
+  if (argc>2)
+  {
+    Position pos;
+    if (!pos.set(argv[1])) {printf("bad fen\n"); return 1;}
+    int depth=atoi(argv[2]);
+    Move list[256], *end=pos.generate(list);
+    uint64_t total=0;
+    t0=now();
+    for(Move *p=list;p<end;p++)
+    {
+      Undo u;
+      pos.make(*p,u);
+      uint64_t n=perft(pos,depth-1);
+      pos.unmake(*p,u);
+      printf("%s %llu\n", Position::uci(*p).c_str(), (unsigned long long)n);
+      total+=n;
+    }
+    double t=now()-t0;
+    printf("total %llu, %.2f s, %.1f Mnps\n", (unsigned long long)total, t, total/t/1e6);
+    return 0;
+  }
+
+  int maxDepth = argc>1 ? atoi(argv[1]) : 5;
+  uint64_t all=0;
+  double time=0;
+  int failed=0;
+  for(const Test &test: tests)
+  {
+    Position pos;
+    pos.set(test.fen);
+    bool ok=true;
+    checked(pos, 3, ok);
+    if (!ok) {printf("%-10s hash differs from scratch\n", test.name); failed++;}
+    if (pos.fen()!=test.fen) {printf("%-10s fen comes back as %s\n", test.name, pos.fen().c_str()); failed++;}
+
+    for(int d=1;d<=maxDepth && test.nodes[d-1];d++)
+    {
+      t0=now();
+      uint64_t n=perft(pos,d);
+      double t=now()-t0;
+      all+=n; time+=t;
+      bool good = n==test.nodes[d-1];
+      failed += !good;
+      printf("%-10s depth %d %12llu %s %8.3f s %6.1f Mnps\n", test.name, d, (unsigned long long)n, good ? "ok " : "BAD", t, n/t/1e6);
+    }
+  }
+  printf("%llu nodes in %.2f s, %.1f Mnps, %s\n", (unsigned long long)all, time, all/time/1e6, failed ? "FAILED" : "all correct");
+  return failed ? 1 : 0;
+}
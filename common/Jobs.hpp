@@ -0,0 +1,83 @@
+#ifndef JOBS_H
+#define JOBS_H
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <vector>
+#include <algorithm>
+
+// Small job system: a fixed pool of worker threads that split an index
+// range into chunks. run() blocks until every chunk is done, the calling
+// thread takes chunks too, so a pool of 0 workers is plain serial code.
+struct Jobs
+{
+  std::vector<std::thread> workers;
+  std::mutex m;
+  std::condition_variable wake, done;
+  std::function<void(int,int)> job;
+  std::atomic<int> next;
+  int count, chunk, generation, busy;
+  bool quit;
+
+  Jobs(int threads = std::thread::hardware_concurrency())
+  {
+    count=chunk=generation=busy=0; next=0; quit=false;
+    for(int i=1;i<threads;i++)
+      workers.push_back(std::thread(&Jobs::loop, this));
+  }
+
+  ~Jobs()
+  {
+    { std::lock_guard<std::mutex> lock(m); quit=true; }
+    wake.notify_all();
+    for(auto &w: workers) w.join();
+  }
+
+  int size() {return workers.size()+1;}
+
+  void run(int n, int grain, std::function<void(int,int)> f)
+  {
+    if (n<=0) return;
+    {
+      std::lock_guard<std::mutex> lock(m);
+      job=f; count=n; chunk=std::max(1,grain); next=0;
+      busy=workers.size(); generation++;
+    }
+    wake.notify_all();
+    work();
+
+    std::unique_lock<std::mutex> lock(m);
+    done.wait(lock, [this]{return busy==0;});
+  }
+
+  void work()
+  {
+    for(int b=next.fetch_add(chunk); b<count; b=next.fetch_add(chunk))
+      job(b, std::min(b+chunk, count));
+  }
+
+  void loop()
+  {
+    int seen=0;
+    for(;;)
+    {
+      {
+        std::unique_lock<std::mutex> lock(m);
+        wake.wait(lock, [&]{return quit || generation!=seen;});
+        if (quit) return;
+        seen=generation;
+      }
+      work();
+      {
+        std::lock_guard<std::mutex> lock(m);
+        busy--;
+      }
+      done.notify_one();
+    }
+  }
+};
+
+#endif
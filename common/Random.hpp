@@ -0,0 +1,21 @@
+#ifndef RANDOM_H
+#define RANDOM_H
+
+#include <cstdint>
+
+// Random numbers that come out the same on every compiler and thread,
+// for games that replay, check or share what they generate.
+
+// next number of a 32-bit xorshift stream; s must not be 0
+inline uint32_t xorshift(uint32_t &s) {s^=s<<13; s^=s>>17; s^=s<<5; return s;}
+
+// a well mixed 64-bit value from any other, for seeds and hash keys
+inline uint64_t splitmix(uint64_t x)
+{
+  x += 0x9e3779b97f4a7c15ull;
+  x = (x^(x>>30))*0xbf58476d1ce4e5b9ull;
+  x = (x^(x>>27))*0x94d049bb133111ebull;
+  return x^(x>>31);
+}
+
+#endif